@@ -6,6 +6,78 @@
 #include <string>
 #include <math.h>
 #include <complex>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <memory>
+#include <initializer_list>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+// Limb storage shared between copies of a BigInteger. Copying only bumps
+// an intrusive atomic reference count, the limbs are duplicated on the first
+// mutation of a buffer that is still shared. The count is dropped with
+// acq_rel and checked with acquire, so everything another thread did with a
+// copy happens before this buffer is written in place. Mutating accessors
+// check the count on every call: loops take data() once per operation.
+// The count, the size and the limbs share one allocation, an empty buffer
+// allocates nothing.
+class LimbBuffer {
+ public:
+  using iterator = int64_t*;
+  using const_iterator = const int64_t*;
+  LimbBuffer();
+  LimbBuffer(std::initializer_list<int64_t>);
+  LimbBuffer(const std::vector<int64_t>&);
+  LimbBuffer(const LimbBuffer&);
+  LimbBuffer(LimbBuffer&&) noexcept;
+  LimbBuffer& operator=(const LimbBuffer&);
+  LimbBuffer& operator=(LimbBuffer&&) noexcept;
+  LimbBuffer& operator=(std::initializer_list<int64_t>);
+  ~LimbBuffer();
+  size_t size() const;
+  bool empty() const;
+  bool shared() const;
+  int64_t& operator[](size_t);
+  const int64_t& operator[](size_t) const;
+  int64_t& back();
+  const int64_t& back() const;
+  int64_t* data();
+  const int64_t* data() const;
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  void push_back(int64_t);
+  void pop_back();
+  void resize(size_t, int64_t value = 0);
+  void assign(size_t, int64_t);
+  void clear();
+  iterator insert(iterator, int64_t);
+  friend bool operator==(const LimbBuffer&, const LimbBuffer&);
+ private:
+  // followed by capacity limbs in the same allocation
+  struct Block {
+    std::atomic<size_t> refs;
+    size_t size = 0;
+    size_t capacity;
+    explicit Block(size_t count) : refs(1), capacity(count) {}
+    int64_t* limbs() {
+      return reinterpret_cast<int64_t*>(this + 1);
+    }
+  };
+  Block* block_ = nullptr;
+  static Block* allocate(size_t);
+  void assignLimbs(const int64_t*, size_t);
+  int64_t* reserve(size_t);
+  void release();
+};
 
 class BigInteger {
  public:
@@ -32,27 +104,36 @@ class BigInteger {
   friend std::istream& operator>>(std::istream&, BigInteger&);
   friend BigInteger operator""_bi(unsigned long long);
   friend BigInteger operator""_bi(const char*, size_t);
+  friend BigInteger square(const BigInteger&);
+  friend BigInteger pow10(int);
+  friend BigInteger iroot(const BigInteger&, int);
+  friend class BigAccumulator;
+  friend class ResidueNumber;
   BigInteger modulo() const;
   int Size() const;
+  size_t hash() const;
  private:
   enum class Sign {
     MINUS = -1,
     PLUS = 1
   };
-  std::vector<int64_t> digits_;
+  LimbBuffer digits_;
   Sign sign_ = Sign::PLUS;
   static const int64_t kBase = 1e9;
   bool moduloCmp(const BigInteger&, const BigInteger&);
   BigInteger subtract(BigInteger bi1, const BigInteger& bi2) {
+    int64_t* limbs = bi1.digits_.data();
+    const int64_t* other = bi2.digits_.data();
+    int size = bi2.Size();
     long long remainder = 0;
-    for (int i = 0; i < bi2.Size() || remainder; ++i) {
-      int64_t minus = remainder + (i < bi2.Size() ? bi2.digits_[i] : 0);
+    for (int i = 0; i < size || remainder; ++i) {
+      int64_t minus = remainder + (i < size ? other[i] : 0);
       remainder = 0;
-      if (minus > static_cast<int64_t>(bi1.digits_[i])) {
+      if (minus > limbs[i]) {
         remainder = 1;
-        bi1.digits_[i] += kBase;
+        limbs[i] += kBase;
       }
-      bi1.digits_[i] -= minus;
+      limbs[i] -= minus;
     }
     while (bi1.Size() > 1 && bi1.digits_.back() == 0) {
       bi1.digits_.pop_back();
@@ -61,25 +142,21 @@ class BigInteger {
     return bi1;
   }
   BigInteger sum(BigInteger bi1, const BigInteger& bi2) {
-    int64_t remainder = 0;
-    for (int i = 0; i < bi2.Size() || remainder; ++i) {
-      if (i == bi1.Size()) {
-        bi1.digits_.push_back(0);
-      }
-      bi1.digits_[i] += remainder + (i < bi2.Size() ? bi2.digits_[i] : 0);
-      remainder = bi1.digits_[i] >= kBase;
-      if (remainder) {
-        bi1.digits_[i] -= kBase;
-      }
-    }
+    bi1.addLimbs(bi2);
     return bi1;
   }
   void swap(BigInteger&, BigInteger&);
+  void addLimbs(const BigInteger&);
   BigInteger divByInt(int64_t);
   BigInteger multByInt(int64_t);
+  static int compareLimbs(const std::vector<int64_t>&, const int64_t*, int);
+  static int64_t estimateQuotient(const std::vector<int64_t>&, const int64_t*, int);
+  static void subtractLimbs(std::vector<int64_t>&, const int64_t*, int, int64_t);
   void norm();
 };
 
+bool operator==(const LimbBuffer& limbs1, const LimbBuffer& limbs2);
+
 bool operator==(const BigInteger& bi1, const BigInteger& bi2);
 
 bool operator!=(const BigInteger& bi1, const BigInteger& bi2);
@@ -102,6 +179,210 @@ BigInteger operator/(const BigInteger& bi1, const BigInteger& bi2);
 
 BigInteger operator%(const BigInteger& bi1, const BigInteger& bi2);
 
+BigInteger square(const BigInteger& bi);
+
+BigInteger pow(const BigInteger& base, uint64_t exp);
+
+BigInteger pow10(int n);
+
+BigInteger isqrt(const BigInteger& bi);
+
+BigInteger iroot(const BigInteger& bi, int k);
+
+LimbBuffer::LimbBuffer() {}
+
+LimbBuffer::LimbBuffer(std::initializer_list<int64_t> limbs) {
+  assignLimbs(limbs.begin(), limbs.size());
+}
+
+LimbBuffer::LimbBuffer(const std::vector<int64_t>& limbs) {
+  assignLimbs(limbs.data(), limbs.size());
+}
+
+LimbBuffer::LimbBuffer(const LimbBuffer& buffer) : block_(buffer.block_) {
+  if (block_ != nullptr) {
+    block_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+LimbBuffer::LimbBuffer(LimbBuffer&& buffer) noexcept : block_(buffer.block_) {
+  buffer.block_ = nullptr;
+}
+
+// The block is taken before release(), which clears block_ on self-assignment
+LimbBuffer& LimbBuffer::operator=(const LimbBuffer& buffer) {
+  Block* block = buffer.block_;
+  if (block != nullptr) {
+    block->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  release();
+  block_ = block;
+  return *this;
+}
+
+LimbBuffer& LimbBuffer::operator=(LimbBuffer&& buffer) noexcept {
+  std::swap(block_, buffer.block_);
+  return *this;
+}
+
+LimbBuffer& LimbBuffer::operator=(std::initializer_list<int64_t> limbs) {
+  assignLimbs(limbs.begin(), limbs.size());
+  return *this;
+}
+
+LimbBuffer::~LimbBuffer() {
+  release();
+}
+
+LimbBuffer::Block* LimbBuffer::allocate(size_t capacity) {
+  void* memory = ::operator new(sizeof(Block) + capacity * sizeof(int64_t));
+  return new (memory) Block(capacity);
+}
+
+// A sole owner can't race with anyone taking a new reference,
+// so it frees the block without the atomic decrement
+void LimbBuffer::release() {
+  if (block_ != nullptr && (block_->refs.load(std::memory_order_acquire) == 1 ||
+                            block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)) {
+    block_->~Block();
+    ::operator delete(block_);
+  }
+  block_ = nullptr;
+}
+
+void LimbBuffer::assignLimbs(const int64_t* limbs, size_t count) {
+  if (block_ == nullptr || shared() || block_->capacity < count) {
+    release();
+    block_ = allocate(count);
+  }
+  std::copy(limbs, limbs + count, block_->limbs());
+  block_->size = count;
+}
+
+// Makes the buffer unshared with room for count limbs, growing geometrically.
+// Writes in place only after observing the last reference with acquire.
+int64_t* LimbBuffer::reserve(size_t count) {
+  size_t capacity = block_ != nullptr ? block_->capacity : 0;
+  if (capacity >= count && !shared()) {
+    return block_ != nullptr ? block_->limbs() : nullptr;
+  }
+  if (capacity < count) {
+    capacity = std::max(count, 2 * capacity);
+  }
+  Block* copy = allocate(capacity);
+  copy->size = size();
+  if (block_ != nullptr) {
+    std::copy(block_->limbs(), block_->limbs() + block_->size, copy->limbs());
+  }
+  release();
+  block_ = copy;
+  return copy->limbs();
+}
+
+size_t LimbBuffer::size() const {
+  return block_ != nullptr ? block_->size : 0;
+}
+
+bool LimbBuffer::empty() const {
+  return size() == 0;
+}
+
+bool LimbBuffer::shared() const {
+  return block_ != nullptr && block_->refs.load(std::memory_order_acquire) > 1;
+}
+
+int64_t& LimbBuffer::operator[](size_t index) {
+  return data()[index];
+}
+
+const int64_t& LimbBuffer::operator[](size_t index) const {
+  return data()[index];
+}
+
+int64_t& LimbBuffer::back() {
+  return data()[size() - 1];
+}
+
+const int64_t& LimbBuffer::back() const {
+  return data()[size() - 1];
+}
+
+int64_t* LimbBuffer::data() {
+  return reserve(size());
+}
+
+const int64_t* LimbBuffer::data() const {
+  return block_ != nullptr ? block_->limbs() : nullptr;
+}
+
+LimbBuffer::iterator LimbBuffer::begin() {
+  return data();
+}
+
+LimbBuffer::iterator LimbBuffer::end() {
+  return data() + size();
+}
+
+LimbBuffer::const_iterator LimbBuffer::begin() const {
+  return data();
+}
+
+LimbBuffer::const_iterator LimbBuffer::end() const {
+  return data() + size();
+}
+
+void LimbBuffer::push_back(int64_t value) {
+  reserve(size() + 1)[block_->size++] = value;
+}
+
+void LimbBuffer::pop_back() {
+  reserve(size());
+  --block_->size;
+}
+
+void LimbBuffer::resize(size_t count, int64_t value) {
+  int64_t* limbs = reserve(count);
+  if (limbs == nullptr) {
+    return;
+  }
+  if (count > block_->size) {
+    std::fill(limbs + block_->size, limbs + count, value);
+  }
+  block_->size = count;
+}
+
+void LimbBuffer::assign(size_t count, int64_t value) {
+  if (block_ == nullptr || shared() || block_->capacity < count) {
+    release();
+    block_ = allocate(count);
+  }
+  std::fill(block_->limbs(), block_->limbs() + count, value);
+  block_->size = count;
+}
+
+void LimbBuffer::clear() {
+  if (shared()) {
+    release();
+  } else if (block_ != nullptr) {
+    block_->size = 0;
+  }
+}
+
+// pos comes from the non-const begin(), so the buffer is already unshared
+LimbBuffer::iterator LimbBuffer::insert(iterator pos, int64_t value) {
+  size_t index = block_ != nullptr ? pos - block_->limbs() : 0;
+  int64_t* limbs = reserve(size() + 1);
+  std::copy_backward(limbs + index, limbs + block_->size, limbs + block_->size + 1);
+  limbs[index] = value;
+  ++block_->size;
+  return limbs + index;
+}
+
+bool operator==(const LimbBuffer& limbs1, const LimbBuffer& limbs2) {
+  return limbs1.block_ == limbs2.block_ ||
+         (limbs1.size() == limbs2.size() && std::equal(limbs1.begin(), limbs1.end(), limbs2.begin()));
+}
+
 BigInteger::BigInteger() : digits_({0}) {}
 
 BigInteger::BigInteger(int64_t num) {
@@ -176,28 +457,40 @@ BigInteger& BigInteger::operator=(const BigInteger& bi) {
 }
 
 BigInteger& BigInteger::operator+=(const BigInteger& bi) {
-  if (*this == 0) {
+  if (!*this) {
     *this = bi;
     return *this;
-  } else if (bi == 0) {
+  } else if (!bi) {
     return *this;
   }
   if (sign_ != bi.sign_) {
     return *this -= (-bi);
   }
+  addLimbs(bi);
+  norm();
+  return *this;
+}
+
+// |*this| += |bi|; the buffer is detached once, then the loop runs on raw limbs
+void BigInteger::addLimbs(const BigInteger& bi) {
+  int size = bi.Size();
+  if (Size() < size) {
+    digits_.resize(size, 0);
+  }
+  int64_t* limbs = digits_.data();
+  const int64_t* other = bi.digits_.data();
   int64_t remainder = 0;
-  for (int i = 0; i < bi.Size() || remainder; ++i) {
-    if (i == Size()) {
-      digits_.push_back(0);
-    }
-    digits_[i] += remainder + (i < bi.Size() ? bi.digits_[i] : 0);
-    remainder = digits_[i] >= kBase;
+  int i = 0;
+  for (; i < size || (remainder && i < Size()); ++i) {
+    limbs[i] += remainder + (i < size ? other[i] : 0);
+    remainder = limbs[i] >= kBase;
     if (remainder) {
-      digits_[i] -= kBase;
+      limbs[i] -= kBase;
     }
   }
-  norm();
-  return *this;
+  if (remainder) {
+    digits_.push_back(1);
+  }
 }
 
 BigInteger& BigInteger::operator-=(const BigInteger& bi) {
@@ -218,6 +511,10 @@ BigInteger& BigInteger::operator-=(const BigInteger& bi) {
 }
 
 BigInteger& BigInteger::operator*=(const BigInteger& bi) {
+  if (this == &bi) {
+    *this = square(*this);
+    return *this;
+  }
   BigInteger temp;
   temp.digits_.resize(Size() + bi.Size());
   if (sign_ != bi.sign_) {
@@ -225,14 +522,15 @@ BigInteger& BigInteger::operator*=(const BigInteger& bi) {
   } else {
     temp.sign_ = BigInteger::Sign::PLUS;
   }
+  // the product always fits into Size() + bi.Size() limbs
+  const int64_t* lhs = static_cast<const LimbBuffer&>(digits_).data();
+  const int64_t* rhs = bi.digits_.data();
+  int64_t* result = temp.digits_.data();
   for (int i = 0; i < Size(); ++i) {
     int64_t remainder = 0;
     for (int j = 0; j < bi.Size() || remainder; ++j) {
-      while (i + j >= temp.Size()) {
-        temp.digits_.push_back(0);
-      }
-      int64_t value = temp.digits_[i + j] + digits_[i] * (j < bi.Size() ? bi.digits_[j] : 0) + remainder;
-      temp.digits_[i + j] = value % kBase;
+      int64_t value = result[i + j] + lhs[i] * (j < bi.Size() ? rhs[j] : 0) + remainder;
+      result[i + j] = value % kBase;
       remainder = value / kBase;
     }
   }
@@ -246,15 +544,16 @@ BigInteger& BigInteger::operator*=(const BigInteger& bi) {
 
 BigInteger BigInteger::multByInt(int64_t num) {
   BigInteger res = *this;
+  int64_t* limbs = res.digits_.data();
   long long remainder = 0;
-  for (int i = 0; i < res.Size() || remainder; ++i) {
-    if (i == res.Size()) {
-      res.digits_.push_back(0);
-    }
-    remainder += res.digits_[i] * num;
-    res.digits_[i] = remainder % kBase;
+  for (int i = 0; i < res.Size(); ++i) {
+    remainder += limbs[i] * num;
+    limbs[i] = remainder % kBase;
     remainder /= kBase;
   }
+  for (; remainder; remainder /= kBase) {
+    res.digits_.push_back(remainder % kBase);
+  }
   while (res.Size() > 1 && res.digits_.back() == 0) {
     res.digits_.pop_back();
   }
@@ -262,7 +561,12 @@ BigInteger BigInteger::multByInt(int64_t num) {
   return res;
 }
 
+// Throws std::domain_error for a zero divisor, which would otherwise be
+// trimmed to no limbs and never stop the long division
 BigInteger& BigInteger::operator/=(const BigInteger& bi) {
+  if (!bi) {
+    throw std::domain_error("BigInteger division by zero");
+  }
   if (sign_ != bi.sign_) {
     sign_ = BigInteger::Sign::MINUS;
   } else {
@@ -280,33 +584,29 @@ BigInteger& BigInteger::operator/=(const BigInteger& bi) {
     norm();
     return *this;
   }
-  BigInteger temp;
+  // long division on raw limbs, temp holds the running remainder
+  std::vector<int64_t> temp;
   BigInteger result;
-  result.digits_.pop_back();
+  result.digits_.assign(Size(), 0);
+  const int64_t* dividend = static_cast<const LimbBuffer&>(digits_).data();
+  const int64_t* divisor = bi.digits_.data();
+  int64_t* quotient = result.digits_.data();
   for (int i = Size() - 1; i >= 0; --i) {
-    temp.digits_.insert(temp.digits_.begin(), digits_[i]);
-    while (temp.Size() > 1 && temp.digits_.back() == 0) {
-      temp.digits_.pop_back();
-    }
-    long long l = 0;
-    long long r = kBase;
-    if (temp >= bimod) {
-      while (r - l > 1) {
-        long long mid = (r + l) / 2;
-        BigInteger denominator = bimod * mid;
-        if (temp - denominator >= 0) {
-          l = mid;
-        } else {
-          r = mid;
-        }
-      }
+    temp.insert(temp.begin(), dividend[i]);
+    while (!temp.empty() && temp.back() == 0) {
+      temp.pop_back();
+    }
+    if (compareLimbs(temp, divisor, bi.Size()) < 0) {
+      continue;
     }
-    result.digits_.push_back(l);
-    if (l > 0) {
-      temp -= bimod * l;
+    int64_t l = estimateQuotient(temp, divisor, bi.Size());
+    subtractLimbs(temp, divisor, bi.Size(), l);
+    while (compareLimbs(temp, divisor, bi.Size()) >= 0) {
+      subtractLimbs(temp, divisor, bi.Size(), 1);
+      ++l;
     }
+    quotient[i] = l;
   }
-  std::reverse(result.digits_.begin(), result.digits_.end());
   digits_ = result.digits_;
   while (Size() > 1 && digits_.back() == 0) {
     digits_.pop_back();
@@ -315,6 +615,66 @@ BigInteger& BigInteger::operator/=(const BigInteger& bi) {
   return *this;
 }
 
+int BigInteger::compareLimbs(const std::vector<int64_t>& limbs1, const int64_t* limbs2, int size2) {
+  int size1 = static_cast<int>(limbs1.size());
+  while (size2 > 0 && limbs2[size2 - 1] == 0) {
+    --size2;
+  }
+  if (size1 != size2) {
+    return size1 < size2 ? -1 : 1;
+  }
+  for (int i = size1 - 1; i >= 0; --i) {
+    if (limbs1[i] != limbs2[i]) {
+      return limbs1[i] < limbs2[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// Quotient digit from the three leading limbs of both numbers. Dropping the
+// lower limbs changes the ratio by less than 1e-6, so after lowering it by
+// a small margin the estimate never exceeds the true digit and is usually exact.
+int64_t BigInteger::estimateQuotient(const std::vector<int64_t>& limbs1, const int64_t* limbs2, int size2) {
+  int size1 = static_cast<int>(limbs1.size());
+  long double leading1 = 0;
+  long double leading2 = 0;
+  for (int i = size1 - 1; i >= std::max(size1 - 3, 0); --i) {
+    leading1 = leading1 * kBase + limbs1[i];
+  }
+  for (int i = size2 - 1; i >= std::max(size2 - 3, 0); --i) {
+    leading2 = leading2 * kBase + limbs2[i];
+  }
+  int shift = std::max(size1 - 3, 0) - std::max(size2 - 3, 0);
+  for (; shift > 0; --shift) {
+    leading1 *= kBase;
+  }
+  for (; shift < 0; ++shift) {
+    leading2 *= kBase;
+  }
+  long double estimate = leading1 / leading2;
+  if (estimate >= kBase) {
+    return kBase - 1;
+  }
+  return std::max(static_cast<int64_t>(estimate - 1e-4L), static_cast<int64_t>(0));
+}
+
+// limbs -= limbs2 * factor, the result must not be negative
+void BigInteger::subtractLimbs(std::vector<int64_t>& limbs1, const int64_t* limbs2, int size2, int64_t factor) {
+  int64_t remainder = 0;
+  for (int i = 0; i < static_cast<int>(limbs1.size()) && (i < size2 || remainder); ++i) {
+    int64_t minus = (i < size2 ? limbs2[i] * factor : 0) + remainder;
+    remainder = minus / kBase;
+    limbs1[i] -= minus % kBase;
+    if (limbs1[i] < 0) {
+      limbs1[i] += kBase;
+      ++remainder;
+    }
+  }
+  while (!limbs1.empty() && limbs1.back() == 0) {
+    limbs1.pop_back();
+  }
+}
+
 BigInteger& BigInteger::operator%=(const BigInteger& bi) {
   BigInteger temp = *this / bi;
   temp *= bi;
@@ -342,6 +702,9 @@ BigInteger operator-(const BigInteger& bi1, const BigInteger& bi2) {
 }
 
 BigInteger operator*(const BigInteger& bi1, const BigInteger& bi2) {
+  if (&bi1 == &bi2) {
+    return square(bi1);
+  }
   BigInteger result;
   if (bi1.Size() <= bi2.Size()) {
     result = bi2;
@@ -456,6 +819,24 @@ int BigInteger::Size() const {
   return static_cast<int>(digits_.size());
 }
 
+size_t hashCombine(size_t seed, uint64_t value) {
+  value *= 0x9e3779b97f4a7c15ULL;
+  value ^= value >> 32;
+  return seed ^ (static_cast<size_t>(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+size_t BigInteger::hash() const {
+  int top = Size() - 1;
+  while (top > 0 && digits_[top] == 0) {
+    --top;
+  }
+  size_t result = sign_ == Sign::MINUS ? 1 : 0;
+  for (int i = 0; i <= top; ++i) {
+    result = hashCombine(result, digits_[i]);
+  }
+  return result;
+}
+
 bool BigInteger::moduloCmp(const BigInteger& bi1, const BigInteger& bi2) {
   if (bi1.Size() != bi2.Size()) {
     return bi1.Size() < bi2.Size();
@@ -509,8 +890,9 @@ void BigInteger::swap(BigInteger& bi1, BigInteger& bi2) {
   std::swap(bi1.sign_, bi2.sign_);
 }
 
+// Reads through the const buffer, so normalizing a copy never detaches it
 void BigInteger::norm() {
-  if (Size() == 1 && digits_[0] == 0) {
+  if (Size() == 1 && static_cast<const LimbBuffer&>(digits_)[0] == 0) {
     sign_ = Sign::PLUS;
   }
 }
@@ -522,9 +904,10 @@ BigInteger BigInteger::divByInt(int64_t num) {
   if (num < 0) {
     res.sign_ = (res.sign_ == Sign::PLUS ? Sign::MINUS : Sign:: PLUS);
   }
+  const int64_t* limbs = static_cast<const LimbBuffer&>(digits_).data();
   long long cur = 0;
   for (int i = Size() - 1; i >= 0; --i) {
-    cur = digits_[i] + cur * kBase;
+    cur = limbs[i] + cur * kBase;
     res.digits_.insert(res.digits_.begin(), cur / num);
     cur %= num;
   }
@@ -535,6 +918,129 @@ BigInteger BigInteger::divByInt(int64_t num) {
   return res;
 }
 
+// Every cross product digits_[i] * digits_[j] is computed once and doubled,
+// which takes about half of the multiplications of operator*=.
+BigInteger square(const BigInteger& bi) {
+  int n = bi.Size();
+  BigInteger result;
+  result.digits_.assign(2 * n, 0);
+  const int64_t* digits = bi.digits_.data();
+  int64_t* res = result.digits_.data();
+  for (int i = 0; i < n; ++i) {
+    int64_t remainder = 0;
+    for (int j = i + 1; j < n; ++j) {
+      int64_t value = res[i + j] + digits[i] * digits[j] + remainder;
+      res[i + j] = value % BigInteger::kBase;
+      remainder = value / BigInteger::kBase;
+    }
+    for (int k = i + n; remainder; ++k) {
+      int64_t value = res[k] + remainder;
+      res[k] = value % BigInteger::kBase;
+      remainder = value / BigInteger::kBase;
+    }
+  }
+  int64_t remainder = 0;
+  for (int k = 0; k < 2 * n; ++k) {
+    int64_t value = 2 * res[k] + remainder;
+    if (k % 2 == 0) {
+      value += digits[k / 2] * digits[k / 2];
+    }
+    res[k] = value % BigInteger::kBase;
+    remainder = value / BigInteger::kBase;
+  }
+  while (result.Size() > 1 && result.digits_.back() == 0) {
+    result.digits_.pop_back();
+  }
+  return result;
+}
+
+// Left-to-right sliding window: only odd powers up to base^(2^window - 1)
+// are precomputed, every other step is a squaring. exp has at most 64 bits,
+// where a window of 3 already costs as many multiplications as it saves.
+BigInteger pow(const BigInteger& base, uint64_t exp) {
+  int bits = 0;
+  while (bits < 64 && (exp >> bits) != 0) {
+    ++bits;
+  }
+  int window = bits > 16 ? 3 : bits > 4 ? 2 : 1;
+  std::vector<BigInteger> odd(1 << (window - 1));
+  odd[0] = base;
+  if (odd.size() > 1) {
+    BigInteger base2 = square(base);
+    for (size_t i = 1; i < odd.size(); ++i) {
+      odd[i] = odd[i - 1] * base2;
+    }
+  }
+  BigInteger result = 1;
+  for (int i = bits - 1; i >= 0;) {
+    if (!((exp >> i) & 1)) {
+      result = square(result);
+      --i;
+      continue;
+    }
+    int j = std::max(i - window + 1, 0);
+    while (!((exp >> j) & 1)) {
+      ++j;
+    }
+    for (int k = j; k <= i; ++k) {
+      result = square(result);
+    }
+    result *= odd[((exp >> j) & ((uint64_t(1) << (i - j + 1)) - 1)) >> 1];
+    i = j - 1;
+  }
+  return result;
+}
+
+// kBase is a power of ten, so 10^n is just n / 9 zero limbs and a short top limb.
+// Negative n gives 1, like n == 0.
+BigInteger pow10(int n) {
+  if (n <= 0) {
+    return 1;
+  }
+  int baseCount = log10(BigInteger::kBase);
+  BigInteger result;
+  result.digits_.assign(n / baseCount + 1, 0);
+  int64_t top = 1;
+  for (int i = 0; i < n % baseCount; ++i) {
+    top *= 10;
+  }
+  result.digits_.back() = top;
+  return result;
+}
+
+BigInteger isqrt(const BigInteger& bi) {
+  return iroot(bi, 2);
+}
+
+// Newton iteration x = ((k - 1) * x + bi / x^(k - 1)) / k, started above
+// the root, decreases monotonically down to floor(bi^(1/k)).
+// Throws std::invalid_argument if k <= 0 and std::domain_error for an even
+// root of a negative number.
+BigInteger iroot(const BigInteger& bi, int k) {
+  if (k <= 0) {
+    throw std::invalid_argument("iroot of a non-positive degree");
+  }
+  if (bi.sign_ == BigInteger::Sign::MINUS) {
+    if (k % 2 == 0) {
+      throw std::domain_error("even iroot of a negative number");
+    }
+    return -iroot(-bi, k);
+  }
+  if (!bi || k == 1) {
+    return bi;
+  }
+  int baseCount = log10(BigInteger::kBase);
+  int length = (bi.Size() - 1) * baseCount + static_cast<int>(std::to_string(bi.digits_.back()).size());
+  BigInteger x = pow10((length + k - 1) / k);
+  while (true) {
+    BigInteger y = (x.multByInt(k - 1) + bi / pow(x, k - 1)).divByInt(k);
+    if (y >= x) {
+      return x;
+    }
+    x = y;
+  }
+}
+
 class Rational {
  public:
   Rational();
@@ -549,17 +1055,21 @@ class Rational {
   Rational operator-() const;
   std::string toString();
   std::string asDecimal(int);
+  size_t hash() const;
+  const BigInteger& numerator() const;
+  const BigInteger& denominator() const;
   explicit operator double() {
     double temp = std::stod(asDecimal(300));
     return temp;
   }
   friend bool operator<(const Rational& rat1, const Rational& rat2);
+  friend class RationalAccumulator;
  private:
   BigInteger p;
   BigInteger q;
   void norm();
-  BigInteger findDenominator(const BigInteger&, const BigInteger&);
-  BigInteger nod(const BigInteger&, const BigInteger&);
+  static BigInteger findDenominator(const BigInteger&, const BigInteger&);
+  static BigInteger nod(const BigInteger&, const BigInteger&);
 };
 
 bool operator==(const Rational& rat1, const Rational& rat2);
@@ -693,10 +1203,7 @@ std::string Rational::asDecimal(int precision = 0) {
   p /= d;
   q /= d;
   Rational copy = *this;
-  BigInteger step(1);
-  for (int i = 0; i < precision; ++i) {
-    step *= 10;
-  }
+  BigInteger step = pow10(precision);
   copy *= step;
   res = (copy.p / copy.q).toString();
   copy /= step;
@@ -741,4 +1248,640 @@ BigInteger Rational::findDenominator(const BigInteger& a, const BigInteger& b) {
   return a * b / d;
 }
 
+const BigInteger& Rational::numerator() const {
+  return p;
+}
+
+const BigInteger& Rational::denominator() const {
+  return q;
+}
+
+// Equal Rationals may be stored as different fractions,
+// so the hash is taken from the reduced one.
+size_t Rational::hash() const {
+  BigInteger d = nod(p.modulo(), q.modulo());
+  BigInteger num = p / d;
+  BigInteger den = q / d;
+  if (den < 0) {
+    num = -num;
+    den = -den;
+  }
+  return hashCombine(num.hash(), den.hash());
+}
+
+namespace std {
+template<>
+struct hash<BigInteger> {
+  size_t operator()(const BigInteger& bi) const {
+    return bi.hash();
+  }
+};
+
+template<>
+struct hash<Rational> {
+  size_t operator()(const Rational& rat) const {
+    return rat.hash();
+  }
+};
+}
+
+// Sums many values without normalizing carries on every addition.
+// Limbs are added into wide int64_t buffers and carries are resolved
+// only when value() is called (or when the buffers could overflow).
+class BigAccumulator {
+ public:
+  BigAccumulator& operator+=(const BigInteger&);
+  BigAccumulator& operator-=(const BigInteger&);
+  BigInteger value();
+  void clear();
+ private:
+  std::vector<int64_t> positive_;
+  std::vector<int64_t> negative_;
+  int64_t pending_ = 0;
+  // every limb is below kBase, so this many additions can't overflow int64_t
+  static const int64_t kMaxPending = 1e9;
+  void add(std::vector<int64_t>&, const BigInteger&);
+  void carry(std::vector<int64_t>&);
+  BigInteger fromLimbs(const std::vector<int64_t>&);
+};
+
+// Sums Rationals over a common denominator. The denominator is only
+// extended when a summand doesn't divide it, numerators go to BigAccumulator.
+class RationalAccumulator {
+ public:
+  RationalAccumulator& operator+=(const Rational&);
+  RationalAccumulator& operator-=(const Rational&);
+  Rational value();
+  void clear();
+ private:
+  BigAccumulator numerator_;
+  BigInteger denominator_ = 1;
+};
+
+template<typename T>
+struct AccumulatorFor;
+
+template<>
+struct AccumulatorFor<BigInteger> {
+  using type = BigAccumulator;
+};
+
+template<>
+struct AccumulatorFor<Rational> {
+  using type = RationalAccumulator;
+};
+
+template<typename Range>
+using RangeValue = typename std::decay<decltype(*std::begin(std::declval<const Range&>()))>::type;
+
+template<typename Range, typename T = RangeValue<Range>>
+T sum(const Range& range) {
+  typename AccumulatorFor<T>::type acc;
+  for (const auto& value : range) {
+    acc += value;
+  }
+  return acc.value();
+}
+
+template<typename Range1, typename Range2, typename T = RangeValue<Range1>>
+T dot(const Range1& range1, const Range2& range2) {
+  typename AccumulatorFor<T>::type acc;
+  auto it1 = std::begin(range1);
+  auto it2 = std::begin(range2);
+  for (; it1 != std::end(range1) && it2 != std::end(range2); ++it1, ++it2) {
+    acc += *it1 * *it2;
+  }
+  return acc.value();
+}
+
+BigAccumulator& BigAccumulator::operator+=(const BigInteger& bi) {
+  if (bi.sign_ == BigInteger::Sign::PLUS) {
+    add(positive_, bi);
+  } else {
+    add(negative_, bi);
+  }
+  return *this;
+}
+
+BigAccumulator& BigAccumulator::operator-=(const BigInteger& bi) {
+  if (bi.sign_ == BigInteger::Sign::PLUS) {
+    add(negative_, bi);
+  } else {
+    add(positive_, bi);
+  }
+  return *this;
+}
+
+BigInteger BigAccumulator::value() {
+  carry(positive_);
+  carry(negative_);
+  pending_ = 0;
+  return fromLimbs(positive_) - fromLimbs(negative_);
+}
+
+void BigAccumulator::clear() {
+  positive_.clear();
+  negative_.clear();
+  pending_ = 0;
+}
+
+void BigAccumulator::add(std::vector<int64_t>& limbs, const BigInteger& bi) {
+  if (pending_ == kMaxPending) {
+    carry(positive_);
+    carry(negative_);
+    pending_ = 0;
+  }
+  if (static_cast<int>(limbs.size()) < bi.Size()) {
+    limbs.resize(bi.Size(), 0);
+  }
+  for (int i = 0; i < bi.Size(); ++i) {
+    limbs[i] += bi.digits_[i];
+  }
+  ++pending_;
+}
+
+void BigAccumulator::carry(std::vector<int64_t>& limbs) {
+  int64_t remainder = 0;
+  for (size_t i = 0; i < limbs.size() || remainder; ++i) {
+    if (i == limbs.size()) {
+      limbs.push_back(0);
+    }
+    limbs[i] += remainder;
+    remainder = limbs[i] / BigInteger::kBase;
+    limbs[i] %= BigInteger::kBase;
+  }
+}
+
+BigInteger BigAccumulator::fromLimbs(const std::vector<int64_t>& limbs) {
+  BigInteger result;
+  if (limbs.empty()) {
+    return result;
+  }
+  result.digits_ = limbs;
+  while (result.Size() > 1 && result.digits_.back() == 0) {
+    result.digits_.pop_back();
+  }
+  return result;
+}
+
+RationalAccumulator& RationalAccumulator::operator+=(const Rational& rat) {
+  if (rat.q == denominator_) {
+    numerator_ += rat.p;
+    return *this;
+  }
+  BigInteger den = Rational::findDenominator(denominator_, rat.q);
+  if (den != denominator_) {
+    BigInteger current = numerator_.value();
+    numerator_.clear();
+    numerator_ += current * (den / denominator_);
+    denominator_ = den;
+  }
+  numerator_ += rat.p * (den / rat.q);
+  return *this;
+}
+
+RationalAccumulator& RationalAccumulator::operator-=(const Rational& rat) {
+  return *this += -rat;
+}
+
+Rational RationalAccumulator::value() {
+  Rational result;
+  result.p = numerator_.value();
+  result.q = denominator_;
+  return result;
+}
+
+void RationalAccumulator::clear() {
+  numerator_.clear();
+  denominator_ = 1;
+}
+
+// Multiplies all values pairwise level by level, so that operands of
+// similar size meet each other instead of one ever-growing accumulator.
+BigInteger productTree(std::vector<BigInteger> values) {
+  if (values.empty()) {
+    return 1;
+  }
+  while (values.size() > 1) {
+    size_t half = 0;
+    for (size_t i = 0; i < values.size(); i += 2) {
+      if (i + 1 < values.size()) {
+        values[half++] = values[i] * values[i + 1];
+      } else {
+        values[half++] = values[i];
+      }
+    }
+    values.resize(half);
+  }
+  return values[0];
+}
+
+template<typename Range>
+BigInteger product(const Range& range) {
+  std::vector<BigInteger> values;
+  for (const auto& value : range) {
+    values.push_back(BigInteger(value));
+  }
+  return productTree(std::move(values));
+}
+
+std::vector<int> primesUpTo(int n) {
+  std::vector<int> primes;
+  std::vector<bool> composite(n + 1, false);
+  for (int i = 2; i <= n; ++i) {
+    if (composite[i]) {
+      continue;
+    }
+    primes.push_back(i);
+    for (int64_t j = static_cast<int64_t>(i) * i; j <= n; j += i) {
+      composite[j] = true;
+    }
+  }
+  return primes;
+}
+
+// n! / ((n / 2)!)^2, every prime power in it is at most n
+BigInteger primeSwing(int n, const std::vector<int>& primes) {
+  std::vector<BigInteger> factors;
+  for (size_t i = 0; i < primes.size() && primes[i] <= n; ++i) {
+    int64_t power = 1;
+    for (int64_t q = n / primes[i]; q > 0; q /= primes[i]) {
+      if (q % 2 == 1) {
+        power *= primes[i];
+      }
+    }
+    if (power > 1) {
+      factors.push_back(power);
+    }
+  }
+  return productTree(std::move(factors));
+}
+
+BigInteger factorial(int n, const std::vector<int>& primes) {
+  if (n < 2) {
+    return 1;
+  }
+  return square(factorial(n / 2, primes)) * primeSwing(n, primes);
+}
+
+BigInteger factorial(int n) {
+  return factorial(n, primesUpTo(n));
+}
+
+BigInteger binomial(int n, int k) {
+  if (k < 0 || k > n) {
+    return 0;
+  }
+  std::vector<BigInteger> factors;
+  for (int p : primesUpTo(n)) {
+    int64_t power = 1;
+    for (int64_t pk = p; pk <= n; pk *= p) {
+      int64_t e = n / pk - k / pk - (n - k) / pk;
+      while (e-- > 0) {
+        power *= p;
+      }
+    }
+    if (power > 1) {
+      factors.push_back(power);
+    }
+  }
+  return productTree(std::move(factors));
+}
+
+struct PairHash {
+  template<typename T1, typename T2>
+  size_t operator()(const std::pair<T1, T2>& pair) const {
+    return hashCombine(std::hash<T1>()(pair.first), std::hash<T2>()(pair.second));
+  }
+};
+
+// Thread-safe memoization of expensive results (gcds, powers, decimal
+// expansions). Keys are spread over independently locked shards, and a
+// missing value is computed outside of the lock.
+// With maxEntriesPerShard = 0 the cache is unbounded, otherwise an arbitrary
+// entry of a full shard is evicted.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class MemoCache {
+ public:
+  explicit MemoCache(size_t maxEntriesPerShard = 0);
+  bool find(const Key&, Value&) const;
+  void insert(const Key&, const Value&);
+  template<typename Compute>
+  Value getOrCompute(const Key&, Compute);
+  size_t size() const;
+  void clear();
+ private:
+  static const size_t kShards = 16;
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Value, Hash> values;
+  };
+  std::array<Shard, kShards> shards_;
+  size_t maxEntriesPerShard_;
+  Hash hash_;
+  size_t shardIndex(const Key&) const;
+};
+
+template<typename Key, typename Value, typename Hash>
+MemoCache<Key, Value, Hash>::MemoCache(size_t maxEntriesPerShard) : maxEntriesPerShard_(maxEntriesPerShard) {}
+
+template<typename Key, typename Value, typename Hash>
+bool MemoCache<Key, Value, Hash>::find(const Key& key, Value& value) const {
+  const Shard& shard = shards_[shardIndex(key)];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.values.find(key);
+  if (it == shard.values.end()) {
+    return false;
+  }
+  value = it->second;
+  return true;
+}
+
+template<typename Key, typename Value, typename Hash>
+void MemoCache<Key, Value, Hash>::insert(const Key& key, const Value& value) {
+  Shard& shard = shards_[shardIndex(key)];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (maxEntriesPerShard_ > 0 && shard.values.size() >= maxEntriesPerShard_ && !shard.values.count(key)) {
+    shard.values.erase(shard.values.begin());
+  }
+  shard.values[key] = value;
+}
+
+template<typename Key, typename Value, typename Hash>
+template<typename Compute>
+Value MemoCache<Key, Value, Hash>::getOrCompute(const Key& key, Compute compute) {
+  Value value;
+  if (find(key, value)) {
+    return value;
+  }
+  value = compute(key);
+  insert(key, value);
+  return value;
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t MemoCache<Key, Value, Hash>::size() const {
+  size_t result = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    result += shard.values.size();
+  }
+  return result;
+}
+
+template<typename Key, typename Value, typename Hash>
+void MemoCache<Key, Value, Hash>::clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.values.clear();
+  }
+}
+
+template<typename Key, typename Value, typename Hash>
+size_t MemoCache<Key, Value, Hash>::shardIndex(const Key& key) const {
+  size_t h = hash_(key);
+  return (h ^ (h >> 17)) % kShards;
+}
+
+// An integer stored as residues modulo primes between 2^30 and 2^31.
+// +, - and * work on every prime independently, and toBigInteger()
+// restores the exact value with the Chinese remainder theorem (Garner's
+// algorithm). bits_ bounds log2 of the absolute value; before an operation
+// could outgrow the product of the primes, more primes are added,
+// up to kMaxPrimes (values of about two million bits); an operation that
+// would need more throws std::length_error and leaves the number unchanged.
+class ResidueNumber {
+ public:
+  ResidueNumber();
+  ResidueNumber(int64_t);
+  ResidueNumber(const BigInteger&);
+  ResidueNumber& operator+=(const ResidueNumber&);
+  ResidueNumber& operator-=(const ResidueNumber&);
+  ResidueNumber& operator*=(const ResidueNumber&);
+  ResidueNumber operator-() const;
+  BigInteger toBigInteger() const;
+  size_t primes() const;
+ private:
+  std::vector<uint32_t> residues_;
+  int64_t bits_ = 0;
+  static const int kPrimeBits = 30;
+  static const size_t kMaxPrimes = 1 << 16;
+  static const uint32_t* primeTable(size_t);
+  static size_t primesFor(int64_t);
+  size_t primesNeeded(int64_t, const ResidueNumber&) const;
+  static uint64_t powMod(uint64_t, uint64_t, uint64_t);
+  void extend(size_t);
+  const uint32_t* residuesFor(size_t, std::vector<uint32_t>&) const;
+  void assign(const BigInteger&, size_t);
+};
+
+ResidueNumber operator+(const ResidueNumber& rn1, const ResidueNumber& rn2);
+
+ResidueNumber operator-(const ResidueNumber& rn1, const ResidueNumber& rn2);
+
+ResidueNumber operator*(const ResidueNumber& rn1, const ResidueNumber& rn2);
+
+ResidueNumber::ResidueNumber() : ResidueNumber(BigInteger()) {}
+
+ResidueNumber::ResidueNumber(int64_t num) : ResidueNumber(BigInteger(num)) {}
+
+ResidueNumber::ResidueNumber(const BigInteger& bi) {
+  // every limb is below 2^30
+  bits_ = static_cast<int64_t>(bi.Size()) * kPrimeBits;
+  assign(bi, primesFor(bits_));
+}
+
+ResidueNumber& ResidueNumber::operator+=(const ResidueNumber& rn) {
+  int64_t bits = std::max(bits_, rn.bits_) + 1;
+  size_t count = primesNeeded(bits, rn);
+  bits_ = bits;
+  extend(count);
+  std::vector<uint32_t> spare;
+  const uint32_t* other = rn.residuesFor(count, spare);
+  const uint32_t* p = primeTable(count);
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t sum = residues_[i] + other[i];
+    residues_[i] = sum >= p[i] ? sum - p[i] : sum;
+  }
+  return *this;
+}
+
+ResidueNumber& ResidueNumber::operator-=(const ResidueNumber& rn) {
+  return *this += -rn;
+}
+
+ResidueNumber& ResidueNumber::operator*=(const ResidueNumber& rn) {
+  int64_t bits = bits_ + rn.bits_;
+  size_t count = primesNeeded(bits, rn);
+  bits_ = bits;
+  extend(count);
+  std::vector<uint32_t> spare;
+  const uint32_t* other = rn.residuesFor(count, spare);
+  const uint32_t* p = primeTable(count);
+  for (size_t i = 0; i < count; ++i) {
+    residues_[i] = static_cast<uint64_t>(residues_[i]) * other[i] % p[i];
+  }
+  return *this;
+}
+
+ResidueNumber ResidueNumber::operator-() const {
+  ResidueNumber copy = *this;
+  const uint32_t* p = primeTable(primes());
+  for (size_t i = 0; i < primes(); ++i) {
+    copy.residues_[i] = residues_[i] == 0 ? 0 : p[i] - residues_[i];
+  }
+  return copy;
+}
+
+ResidueNumber operator+(const ResidueNumber& rn1, const ResidueNumber& rn2) {
+  ResidueNumber result = rn1;
+  result += rn2;
+  return result;
+}
+
+ResidueNumber operator-(const ResidueNumber& rn1, const ResidueNumber& rn2) {
+  ResidueNumber result = rn1;
+  result -= rn2;
+  return result;
+}
+
+ResidueNumber operator*(const ResidueNumber& rn1, const ResidueNumber& rn2) {
+  ResidueNumber result = rn1;
+  result *= rn2;
+  return result;
+}
+
+// Garner: x = v[0] + v[1] * p[0] + v[2] * p[0] * p[1] + ..., where each
+// mixed radix digit v[i] < p[i] is found modulo p[i] alone.
+BigInteger ResidueNumber::toBigInteger() const {
+  size_t count = primes();
+  const uint32_t* p = primeTable(count);
+  std::vector<uint64_t> mixed(count);
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t value = 0;
+    uint64_t product = 1;
+    for (size_t j = 0; j < i; ++j) {
+      value = (value + mixed[j] * product) % p[i];
+      product = product * p[j] % p[i];
+    }
+    uint64_t diff = (residues_[i] + p[i] - value) % p[i];
+    mixed[i] = diff * powMod(product, p[i] - 2, p[i]) % p[i];
+  }
+  BigInteger result;
+  BigInteger modulus = 1;
+  for (size_t i = count; i-- > 0;) {
+    result = result.multByInt(p[i]) + BigInteger(static_cast<int64_t>(mixed[i]));
+    modulus = modulus.multByInt(p[i]);
+  }
+  // values above half of the modulus stand for negative numbers
+  if (result.multByInt(2) > modulus) {
+    result -= modulus;
+  }
+  return result;
+}
+
+size_t ResidueNumber::primes() const {
+  return residues_.size();
+}
+
+// Generated on demand, the table never reallocates, so readers only
+// need the published count.
+const uint32_t* ResidueNumber::primeTable(size_t count) {
+  if (count > kMaxPrimes) {
+    throw std::length_error("ResidueNumber needs more than kMaxPrimes primes");
+  }
+  static std::vector<uint32_t> table(kMaxPrimes);
+  static std::atomic<size_t> generated(0);
+  static std::mutex mutex;
+  if (generated.load(std::memory_order_acquire) < count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t size = generated.load(std::memory_order_relaxed);
+    uint32_t candidate = size == 0 ? (uint32_t(1) << 31) : table[size - 1];
+    while (size < count) {
+      candidate -= 1;
+      bool prime = true;
+      for (uint32_t d = 2; d * d <= candidate; ++d) {
+        if (candidate % d == 0) {
+          prime = false;
+          break;
+        }
+      }
+      if (prime) {
+        table[size++] = candidate;
+      }
+    }
+    generated.store(size, std::memory_order_release);
+  }
+  return table.data();
+}
+
+size_t ResidueNumber::primesFor(int64_t bits) {
+  // one spare bit for the sign
+  size_t count = static_cast<size_t>((bits + 1) / kPrimeBits + 1);
+  if (count > kMaxPrimes) {
+    throw std::length_error("ResidueNumber needs more than kMaxPrimes primes");
+  }
+  return count;
+}
+
+// Primes for a result of the given size and both operands. When the bound
+// outgrows them, a quarter more is added in reserve: every extension
+// reconstructs the value, and += raises the bound on every call.
+size_t ResidueNumber::primesNeeded(int64_t bits, const ResidueNumber& rn) const {
+  size_t count = std::max(primes(), rn.primes());
+  size_t needed = primesFor(bits);
+  if (needed <= count) {
+    return count;
+  }
+  needed += needed / 4;
+  return needed > kMaxPrimes ? primesFor(bits) : needed;
+}
+
+uint64_t ResidueNumber::powMod(uint64_t base, uint64_t exp, uint64_t mod) {
+  uint64_t result = 1;
+  base %= mod;
+  while (exp) {
+    if (exp & 1) {
+      result = result * base % mod;
+    }
+    base = base * base % mod;
+    exp >>= 1;
+  }
+  return result;
+}
+
+void ResidueNumber::extend(size_t count) {
+  if (count > primes()) {
+    assign(toBigInteger(), count);
+  }
+}
+
+// The residues modulo the first count primes; the value is only copied
+// and extended (into spare) when it has fewer primes than that
+const uint32_t* ResidueNumber::residuesFor(size_t count, std::vector<uint32_t>& spare) const {
+  if (primes() >= count) {
+    return residues_.data();
+  }
+  ResidueNumber copy = *this;
+  copy.extend(count);
+  spare.swap(copy.residues_);
+  return spare.data();
+}
+
+void ResidueNumber::assign(const BigInteger& bi, size_t count) {
+  const uint32_t* p = primeTable(count);
+  size_t from = residues_.size();
+  residues_.resize(count);
+  for (size_t i = from; i < count; ++i) {
+    uint64_t value = 0;
+    for (int j = bi.Size() - 1; j >= 0; --j) {
+      value = (value * BigInteger::kBase + bi.digits_[j]) % p[i];
+    }
+    if (bi.sign_ == BigInteger::Sign::MINUS && value != 0) {
+      value = p[i] - value;
+    }
+    residues_[i] = static_cast<uint32_t>(value);
+  }
+}
+
 #endif /* biginteger_h */
\ No newline at end of file
@@ -0,0 +1,255 @@
+#ifndef fileinput_h
+#define fileinput_h
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cctype>
+#include "string.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILEINPUT_MMAP
+#endif
+
+// Read-only contents of a whole file without copying: the file is mapped
+// into memory where mmap is available, otherwise it is read into a String.
+class MappedFile {
+ public:
+  MappedFile ();
+
+  explicit MappedFile (const char*);
+
+  MappedFile (const MappedFile&) = delete;
+
+  MappedFile (MappedFile&&) noexcept;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile& operator=(MappedFile&&) noexcept;
+
+  bool open(const char*);
+
+  void close();
+
+  bool is_open() const;
+
+  size_t size() const;
+
+  StringView view() const;
+
+  ~MappedFile();
+ private:
+  const char* ptr = nullptr;
+  size_t sz = 0;
+  bool opened = false;
+  bool mapped = false;
+  String contents;
+
+  void swap(MappedFile&);
+};
+
+// Reads a stream in large blocks and returns lines or whitespace-separated
+// tokens as views into its buffer, so nothing is copied per line.
+// A returned view stays valid only until the next call.
+class ChunkedReader {
+ public:
+  explicit ChunkedReader (std::istream&, size_t = 1 << 20);
+
+  bool next_line(StringView&);
+
+  bool next_token(StringView&);
+ private:
+  std::istream* stream;
+  std::vector<char> buffer;
+  size_t begin = 0;
+  size_t end = 0;
+  bool eof = false;
+
+  void fill();
+};
+
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const char* path) {
+  open(path);
+}
+
+MappedFile::MappedFile(MappedFile&& file) noexcept {
+  swap(file);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& file) noexcept {
+  close();
+  swap(file);
+  return *this;
+}
+
+bool MappedFile::open(const char* path) {
+  close();
+#ifdef FILEINPUT_MMAP
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  // files like those in /proc report a size of 0 and are read as streams
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    sz = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      madvise(address, sz, MADV_SEQUENTIAL);
+      ptr = static_cast<const char*>(address);
+      opened = true;
+      mapped = true;
+    }
+  }
+  ::close(fd);
+  if (opened) {
+    return true;
+  }
+  sz = 0;
+#endif
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return false;
+  }
+  char block[1 << 16];
+  while (stream.read(block, sizeof(block)) || stream.gcount() > 0) {
+    contents.append(block, static_cast<size_t>(stream.gcount()));
+  }
+  ptr = contents.data();
+  sz = contents.size();
+  opened = true;
+  return true;
+}
+
+void MappedFile::close() {
+#ifdef FILEINPUT_MMAP
+  if (mapped) {
+    munmap(const_cast<char*>(ptr), sz);
+  }
+#endif
+  ptr = nullptr;
+  sz = 0;
+  opened = false;
+  mapped = false;
+  contents.clear();
+  contents.shrink_to_fit();
+}
+
+bool MappedFile::is_open() const {
+  return opened;
+}
+
+size_t MappedFile::size() const {
+  return sz;
+}
+
+StringView MappedFile::view() const {
+  return sz == 0 ? StringView() : StringView(ptr, sz);
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+// ptr may point into contents, which moves its local buffer on swap
+void MappedFile::swap(MappedFile& file) {
+  bool owns = opened && !mapped;
+  bool file_owns = file.opened && !file.mapped;
+  std::swap(ptr, file.ptr);
+  std::swap(sz, file.sz);
+  std::swap(opened, file.opened);
+  std::swap(mapped, file.mapped);
+  std::swap(contents, file.contents);
+  if (owns) {
+    file.ptr = file.contents.data();
+  }
+  if (file_owns) {
+    ptr = contents.data();
+  }
+}
+
+ChunkedReader::ChunkedReader(std::istream& stream, size_t chunk)
+    : stream(&stream), buffer(std::max(chunk, static_cast<size_t>(1))) {}
+
+// Moves the unread tail to the front and reads behind it,
+// doubling the buffer when a single line doesn't fit
+void ChunkedReader::fill() {
+  if (begin > 0) {
+    memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    begin = 0;
+  }
+  if (end == buffer.size()) {
+    buffer.resize(buffer.size() * 2);
+  }
+  stream->read(buffer.data() + end, buffer.size() - end);
+  size_t count = static_cast<size_t>(stream->gcount());
+  end += count;
+  if (count == 0) {
+    eof = true;
+  }
+}
+
+bool ChunkedReader::next_line(StringView& line) {
+  size_t scanned = begin;
+  while (true) {
+    const char* found = static_cast<const char*>(memchr(buffer.data() + scanned, '\n', end - scanned));
+    if (found != nullptr) {
+      size_t pos = found - buffer.data();
+      size_t line_end = pos > begin && buffer[pos - 1] == '\r' ? pos - 1 : pos;
+      line = StringView(buffer.data() + begin, line_end - begin);
+      begin = pos + 1;
+      return true;
+    }
+    if (eof) {
+      if (begin == end) {
+        return false;
+      }
+      line = StringView(buffer.data() + begin, end - begin);
+      begin = end;
+      return true;
+    }
+    scanned = end - begin;
+    fill();
+    scanned += begin;
+  }
+}
+
+bool ChunkedReader::next_token(StringView& token) {
+  while (true) {
+    while (begin < end && std::isspace(static_cast<unsigned char>(buffer[begin]))) {
+      ++begin;
+    }
+    if (begin < end) {
+      break;
+    }
+    if (eof) {
+      return false;
+    }
+    fill();
+  }
+  size_t pos = begin;
+  while (true) {
+    while (pos < end && !std::isspace(static_cast<unsigned char>(buffer[pos]))) {
+      ++pos;
+    }
+    if (pos < end || eof) {
+      break;
+    }
+    pos -= begin;
+    fill();
+    pos += begin;
+  }
+  token = StringView(buffer.data() + begin, pos - begin);
+  begin = pos;
+  return true;
+}
+
+#endif /* fileinput_h */
@@ -0,0 +1,284 @@
+#ifndef intern_h
+#define intern_h
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include "string.h"
+
+class StringPool;
+
+// Handle to a string stored once in a StringPool. It is a single pointer:
+// two handles from the same pool are equal exactly when the pointers are,
+// and the hash is computed once at interning. A handle stays valid as long
+// as its pool lives. The default handle is the empty string of no pool.
+class InternedString {
+ public:
+  InternedString ();
+
+  StringView view() const;
+
+  const char* data() const;
+
+  size_t size() const;
+
+  size_t length() const;
+
+  bool empty() const;
+
+  size_t hash() const;
+
+  operator StringView() const;
+
+  friend bool operator==(InternedString, InternedString);
+
+  friend std::ostream& operator<<(std::ostream&, InternedString);
+ private:
+  friend class StringPool;
+
+  struct Entry {
+    size_t hash;
+    size_t sz;
+    const char* chars;
+  };
+
+  const Entry* entry = nullptr;
+
+  explicit InternedString (const Entry*);
+};
+
+bool operator!=(InternedString str1, InternedString str2);
+
+// Ordered by contents, not by address
+bool operator<(InternedString str1, InternedString str2);
+
+// Thread-safe interning arena. Lookups of strings that are already interned
+// take no lock: the table is an open-addressing array of atomic pointers,
+// and entries are never moved or removed once published. Inserting takes a
+// mutex; growing builds a new table and publishes it with one atomic store.
+// Old tables are kept until the pool dies, so readers that still hold one
+// stay safe. All characters and entries live in the pool's own blocks and
+// are released together with it.
+class StringPool {
+ public:
+  StringPool ();
+
+  StringPool (const StringPool&) = delete;
+
+  StringPool& operator=(const StringPool&) = delete;
+
+  InternedString intern(StringView);
+
+  // The default handle if the string hasn't been interned, never inserts
+  InternedString find(StringView) const;
+
+  size_t size() const;
+
+  size_t memory() const;
+ private:
+  using Entry = InternedString::Entry;
+
+  struct Table {
+    size_t mask;
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+
+    explicit Table (size_t);
+  };
+
+  static const size_t kInitialSlots = 64;
+  static const size_t kBlockSize = 1 << 16;
+
+  std::atomic<Table*> table;
+  std::vector<std::unique_ptr<Table>> tables;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  size_t block_used = kBlockSize;
+  size_t allocated = 0;
+  std::atomic<size_t> count;
+  mutable std::mutex mutex;
+
+  static const Entry* lookup(const Table&, StringView, size_t, size_t&);
+
+  char* allocate(size_t, size_t);
+
+  void grow();
+};
+
+namespace std {
+template<>
+struct hash<InternedString> {
+  size_t operator()(InternedString string) const {
+    return string.hash();
+  }
+};
+}
+
+InternedString::InternedString() {}
+
+InternedString::InternedString(const Entry* entry) : entry(entry) {}
+
+StringView InternedString::view() const {
+  return entry ? StringView(entry->chars, entry->sz) : StringView();
+}
+
+const char* InternedString::data() const {
+  return view().data();
+}
+
+size_t InternedString::size() const {
+  return entry ? entry->sz : 0;
+}
+
+size_t InternedString::length() const {
+  return size();
+}
+
+bool InternedString::empty() const {
+  return size() == 0;
+}
+
+size_t InternedString::hash() const {
+  return entry ? entry->hash : hashBytes("", 0);
+}
+
+InternedString::operator StringView() const {
+  return view();
+}
+
+bool operator==(InternedString str1, InternedString str2) {
+  return str1.entry == str2.entry;
+}
+
+bool operator!=(InternedString str1, InternedString str2) {
+  return !(str1 == str2);
+}
+
+bool operator<(InternedString str1, InternedString str2) {
+  return str1 != str2 && str1.view() < str2.view();
+}
+
+std::ostream& operator<<(std::ostream& stream, InternedString string) {
+  return stream << string.view();
+}
+
+StringPool::Table::Table(size_t capacity) : mask(capacity - 1), slots(new std::atomic<const Entry*>[capacity]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+StringPool::StringPool() : count(0) {
+  tables.emplace_back(new Table(kInitialSlots));
+  table.store(tables.back().get(), std::memory_order_release);
+}
+
+// Linear probing; slot receives the position where the search stopped
+const StringPool::Entry* StringPool::lookup(const Table& table, StringView view, size_t hash, size_t& slot) {
+  for (slot = hash & table.mask;; slot = (slot + 1) & table.mask) {
+    const Entry* entry = table.slots[slot].load(std::memory_order_acquire);
+    if (entry == nullptr) {
+      return nullptr;
+    }
+    if (entry->hash == hash && StringView(entry->chars, entry->sz) == view) {
+      return entry;
+    }
+  }
+}
+
+InternedString StringPool::find(StringView view) const {
+  size_t hash = hashBytes(view.data(), view.size());
+  size_t slot = 0;
+  const Table* current = table.load(std::memory_order_acquire);
+  while (true) {
+    const Entry* entry = lookup(*current, view, hash, slot);
+    if (entry != nullptr) {
+      return InternedString(entry);
+    }
+    // a grow may have published the entry in a newer table only
+    const Table* latest = table.load(std::memory_order_acquire);
+    if (latest == current) {
+      return InternedString();
+    }
+    current = latest;
+  }
+}
+
+InternedString StringPool::intern(StringView view) {
+  InternedString found = find(view);
+  if (found.entry != nullptr) {
+    return found;
+  }
+  size_t hash = hashBytes(view.data(), view.size());
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t slot = 0;
+  Table* current = table.load(std::memory_order_relaxed);
+  if (const Entry* entry = lookup(*current, view, hash, slot)) {
+    return InternedString(entry);
+  }
+  char* chars = allocate(view.size() + 1, 1);
+  memcpy(chars, view.data(), view.size());
+  chars[view.size()] = '\0';
+  Entry* entry = reinterpret_cast<Entry*>(allocate(sizeof(Entry), alignof(Entry)));
+  entry->hash = hash;
+  entry->sz = view.size();
+  entry->chars = chars;
+  current->slots[slot].store(entry, std::memory_order_release);
+  // keep the load factor at most one half
+  if (count.fetch_add(1, std::memory_order_relaxed) * 2 + 2 > current->mask + 1) {
+    grow();
+  }
+  return InternedString(entry);
+}
+
+size_t StringPool::size() const {
+  return count.load(std::memory_order_relaxed);
+}
+
+size_t StringPool::memory() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t slots = 0;
+  for (const auto& old : tables) {
+    slots += old->mask + 1;
+  }
+  return allocated + slots * sizeof(std::atomic<const Entry*>);
+}
+
+// Bump allocation from kBlockSize blocks. Large requests get a block of
+// their own, placed before the current one so that it keeps being filled.
+// Called under the mutex.
+char* StringPool::allocate(size_t bytes, size_t align) {
+  if (bytes > kBlockSize / 4) {
+    auto position = blocks.empty() ? blocks.end() : blocks.end() - 1;
+    allocated += bytes;
+    return blocks.emplace(position, new char[bytes])->get();
+  }
+  size_t offset = (block_used + align - 1) / align * align;
+  if (offset + bytes > kBlockSize) {
+    blocks.emplace_back(new char[kBlockSize]);
+    allocated += kBlockSize;
+    offset = 0;
+  }
+  block_used = offset + bytes;
+  return blocks.back().get() + offset;
+}
+
+// Called under the mutex; the old table is retired, not freed
+void StringPool::grow() {
+  const Table& old = *table.load(std::memory_order_relaxed);
+  std::unique_ptr<Table> bigger(new Table((old.mask + 1) * 2));
+  for (size_t i = 0; i <= old.mask; ++i) {
+    const Entry* entry = old.slots[i].load(std::memory_order_relaxed);
+    if (entry != nullptr) {
+      size_t slot = entry->hash & bigger->mask;
+      while (bigger->slots[slot].load(std::memory_order_relaxed) != nullptr) {
+        slot = (slot + 1) & bigger->mask;
+      }
+      bigger->slots[slot].store(entry, std::memory_order_relaxed);
+    }
+  }
+  table.store(bigger.get(), std::memory_order_release);
+  tables.push_back(std::move(bigger));
+}
+
+#endif /* intern_h */
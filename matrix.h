@@ -0,0 +1,278 @@
+#ifndef matrix_h
+#define matrix_h
+
+#include <vector>
+#include <thread>
+#include <initializer_list>
+#include <stdexcept>
+#include "biginteger.h"
+
+template<typename T>
+class Matrix {
+ public:
+  Matrix(size_t, size_t);
+  Matrix(std::initializer_list<std::initializer_list<T>>);
+  size_t rows() const;
+  size_t cols() const;
+  T& operator()(size_t, size_t);
+  const T& operator()(size_t, size_t) const;
+  T* row(size_t);
+  const T* row(size_t) const;
+  void swapRows(size_t, size_t);
+ private:
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+  // row-major, so a row update walks one contiguous block
+  std::vector<T> values_;
+};
+
+// Fraction-free (Bareiss) elimination of the first pivotCols columns in place.
+// Every division is exact and every entry stays a minor of the original
+// matrix, so sizes grow linearly instead of exploding as with Rationals.
+// Returns the rank, swaps is set to the number of row exchanges.
+size_t bareiss(Matrix<BigInteger>& m, size_t pivotCols, int threads, int& swaps);
+
+// Throws std::invalid_argument if m isn't square
+BigInteger determinant(const Matrix<BigInteger>& m, int threads = 1);
+
+Rational determinant(const Matrix<Rational>& m, int threads = 1);
+
+size_t rank(const Matrix<BigInteger>& m, int threads = 1);
+
+size_t rank(const Matrix<Rational>& m, int threads = 1);
+
+// Returns false if the system has no unique solution
+bool solve(const Matrix<BigInteger>& a, const std::vector<BigInteger>& b, std::vector<Rational>& x, int threads = 1);
+
+bool solve(const Matrix<Rational>& a, const std::vector<Rational>& b, std::vector<Rational>& x, int threads = 1);
+
+template<typename T>
+Matrix<T>::Matrix(size_t rows, size_t cols) : rows_(rows), cols_(cols), values_(rows * cols) {}
+
+template<typename T>
+Matrix<T>::Matrix(std::initializer_list<std::initializer_list<T>> values) : rows_(values.size()) {
+  cols_ = rows_ == 0 ? 0 : values.begin()->size();
+  values_.reserve(rows_ * cols_);
+  for (const auto& row : values) {
+    values_.insert(values_.end(), row.begin(), row.end());
+  }
+}
+
+template<typename T>
+size_t Matrix<T>::rows() const {
+  return rows_;
+}
+
+template<typename T>
+size_t Matrix<T>::cols() const {
+  return cols_;
+}
+
+template<typename T>
+T& Matrix<T>::operator()(size_t i, size_t j) {
+  return values_[i * cols_ + j];
+}
+
+template<typename T>
+const T& Matrix<T>::operator()(size_t i, size_t j) const {
+  return values_[i * cols_ + j];
+}
+
+template<typename T>
+T* Matrix<T>::row(size_t i) {
+  return values_.data() + i * cols_;
+}
+
+template<typename T>
+const T* Matrix<T>::row(size_t i) const {
+  return values_.data() + i * cols_;
+}
+
+template<typename T>
+void Matrix<T>::swapRows(size_t i, size_t j) {
+  std::swap_ranges(row(i), row(i) + cols_, row(j));
+}
+
+BigInteger matrixGcd(const BigInteger& x, const BigInteger& y) {
+  return y == 0 ? x : matrixGcd(y, x % y);
+}
+
+// Multiplies every row by the lcm of its denominators, which changes
+// neither the rank nor the solutions. scales receives the multipliers.
+Matrix<BigInteger> clearDenominators(const Matrix<Rational>& m, std::vector<BigInteger>& scales) {
+  Matrix<BigInteger> result(m.rows(), m.cols());
+  scales.assign(m.rows(), 1);
+  for (size_t i = 0; i < m.rows(); ++i) {
+    BigInteger& scale = scales[i];
+    for (size_t j = 0; j < m.cols(); ++j) {
+      BigInteger den = m(i, j).denominator().modulo();
+      if (den != scale) {
+        scale = scale * den / matrixGcd(scale, den);
+      }
+    }
+    for (size_t j = 0; j < m.cols(); ++j) {
+      result(i, j) = m(i, j).numerator() * (scale / m(i, j).denominator());
+    }
+  }
+  return result;
+}
+
+void bareissUpdate(Matrix<BigInteger>& m, size_t pivotRow, size_t col, const BigInteger& prev,
+                   size_t from, size_t to) {
+  const BigInteger* pivot = m.row(pivotRow);
+  bool divide = prev != 1;
+  for (size_t i = from; i < to; ++i) {
+    BigInteger* row = m.row(i);
+    BigInteger factor = row[col];
+    for (size_t j = col + 1; j < m.cols(); ++j) {
+      row[j] *= pivot[col];
+      if (factor) {
+        row[j] -= factor * pivot[j];
+      }
+      if (divide) {
+        row[j] /= prev;
+      }
+    }
+    row[col] = 0;
+  }
+}
+
+// Rows below the pivot don't depend on each other,
+// so they are split between the threads in equal blocks.
+void bareissStep(Matrix<BigInteger>& m, size_t pivotRow, size_t col, const BigInteger& prev, int threads) {
+  size_t from = pivotRow + 1;
+  size_t count = m.rows() - from;
+  size_t workers = std::max(std::min(static_cast<size_t>(threads), count), static_cast<size_t>(1));
+  if (workers == 1) {
+    bareissUpdate(m, pivotRow, col, prev, from, m.rows());
+    return;
+  }
+  std::vector<std::thread> pool;
+  size_t block = (count + workers - 1) / workers;
+  for (size_t start = from + block; start < m.rows(); start += block) {
+    pool.emplace_back(bareissUpdate, std::ref(m), pivotRow, col, std::cref(prev),
+                      start, std::min(start + block, m.rows()));
+  }
+  bareissUpdate(m, pivotRow, col, prev, from, from + block);
+  for (std::thread& worker : pool) {
+    worker.join();
+  }
+}
+
+size_t bareiss(Matrix<BigInteger>& m, size_t pivotCols, int threads, int& swaps) {
+  size_t rank = 0;
+  BigInteger prev = 1;
+  swaps = 0;
+  for (size_t col = 0; col < pivotCols && rank < m.rows(); ++col) {
+    size_t pivot = rank;
+    while (pivot < m.rows() && !m(pivot, col)) {
+      ++pivot;
+    }
+    if (pivot == m.rows()) {
+      continue;
+    }
+    if (pivot != rank) {
+      m.swapRows(pivot, rank);
+      ++swaps;
+    }
+    bareissStep(m, rank, col, prev, threads);
+    prev = m(rank, col);
+    ++rank;
+  }
+  return rank;
+}
+
+BigInteger determinant(const Matrix<BigInteger>& m, int threads) {
+  if (m.rows() != m.cols()) {
+    throw std::invalid_argument("determinant of a non-square matrix");
+  }
+  if (m.rows() == 0) {
+    return 1;
+  }
+  Matrix<BigInteger> copy = m;
+  int swaps = 0;
+  if (bareiss(copy, copy.cols(), threads, swaps) < copy.rows()) {
+    return 0;
+  }
+  BigInteger result = copy(copy.rows() - 1, copy.cols() - 1);
+  return swaps % 2 == 0 ? result : -result;
+}
+
+Rational determinant(const Matrix<Rational>& m, int threads) {
+  if (m.rows() != m.cols()) {
+    throw std::invalid_argument("determinant of a non-square matrix");
+  }
+  std::vector<BigInteger> scales;
+  Matrix<BigInteger> scaled = clearDenominators(m, scales);
+  return Rational(determinant(scaled, threads)) / Rational(productTree(scales));
+}
+
+size_t rank(const Matrix<BigInteger>& m, int threads) {
+  Matrix<BigInteger> copy = m;
+  int swaps = 0;
+  return bareiss(copy, copy.cols(), threads, swaps);
+}
+
+size_t rank(const Matrix<Rational>& m, int threads) {
+  std::vector<BigInteger> scales;
+  Matrix<BigInteger> scaled = clearDenominators(m, scales);
+  int swaps = 0;
+  return bareiss(scaled, scaled.cols(), threads, swaps);
+}
+
+// After elimination the last column of the augmented matrix is c with
+// U * x = c, and d * x is integral for d = det(U) = U(n - 1, n - 1).
+// Back substitution on y = d * x therefore divides exactly.
+bool solveAugmented(Matrix<BigInteger>& aug, std::vector<Rational>& x, int threads) {
+  size_t n = aug.rows();
+  int swaps = 0;
+  if (aug.cols() != n + 1 || bareiss(aug, n, threads, swaps) < n) {
+    return false;
+  }
+  if (n == 0) {
+    x.clear();
+    return true;
+  }
+  BigInteger det = aug(n - 1, n - 1);
+  std::vector<BigInteger> y(n);
+  for (size_t i = n; i-- > 0;) {
+    BigInteger value = det * aug(i, n);
+    for (size_t j = i + 1; j < n; ++j) {
+      value -= aug(i, j) * y[j];
+    }
+    y[i] = value / aug(i, i);
+  }
+  x.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = Rational(y[i]) / Rational(det);
+  }
+  return true;
+}
+
+bool solve(const Matrix<BigInteger>& a, const std::vector<BigInteger>& b, std::vector<Rational>& x, int threads) {
+  if (a.rows() != a.cols() || b.size() != a.rows()) {
+    return false;
+  }
+  Matrix<BigInteger> aug(a.rows(), a.cols() + 1);
+  for (size_t i = 0; i < a.rows(); ++i) {
+    std::copy(a.row(i), a.row(i) + a.cols(), aug.row(i));
+    aug(i, a.cols()) = b[i];
+  }
+  return solveAugmented(aug, x, threads);
+}
+
+bool solve(const Matrix<Rational>& a, const std::vector<Rational>& b, std::vector<Rational>& x, int threads) {
+  if (a.rows() != a.cols() || b.size() != a.rows()) {
+    return false;
+  }
+  Matrix<Rational> rational(a.rows(), a.cols() + 1);
+  for (size_t i = 0; i < a.rows(); ++i) {
+    std::copy(a.row(i), a.row(i) + a.cols(), rational.row(i));
+    rational(i, a.cols()) = b[i];
+  }
+  std::vector<BigInteger> scales;
+  Matrix<BigInteger> aug = clearDenominators(rational, scales);
+  return solveAugmented(aug, x, threads);
+}
+
+#endif /* matrix_h */
@@ -0,0 +1,187 @@
+#ifndef multisearch_h
+#define multisearch_h
+
+#include <vector>
+#include <cstdint>
+#include "string.h"
+
+// Aho-Corasick automaton over a fixed set of patterns, reporting every
+// occurrence of every pattern in one pass over the text.
+// Bytes that occur in no pattern share one alphabet class, so the complete
+// transition table stays dense: states * classes entries, one lookup per byte.
+// Empty patterns never match.
+class MultiPatternMatcher {
+ public:
+  struct Match {
+    size_t pattern;
+    size_t position;
+  };
+
+  // Matches text that arrives in chunks, occurrences may cross chunk borders.
+  // Positions are counted from the beginning of the whole stream.
+  class Scanner {
+   public:
+    explicit Scanner (const MultiPatternMatcher&);
+
+    template<typename Callback>
+    void feed(StringView, Callback);
+
+    void reset();
+
+    size_t position() const;
+   private:
+    const MultiPatternMatcher* matcher;
+    int32_t state = 0;
+    size_t offset = 0;
+  };
+
+  explicit MultiPatternMatcher (const std::vector<String>&);
+
+  size_t patterns() const;
+
+  size_t states() const;
+
+  std::vector<Match> find_all(StringView) const;
+
+  template<typename Callback>
+  void scan(StringView, Callback) const;
+
+  Scanner scanner() const;
+ private:
+  uint8_t classes[256];
+  size_t alphabet = 1;
+  std::vector<int32_t> transitions;
+  // first state on the suffix-link chain (the state itself included)
+  // where a pattern ends, and the next such state after it; -1 if none
+  std::vector<int32_t> output;
+  std::vector<int32_t> next_output;
+  // patterns ending in state s are ends_patterns[ends[s] .. ends[s + 1])
+  std::vector<int32_t> ends;
+  std::vector<int32_t> ends_patterns;
+  std::vector<size_t> lengths;
+
+  template<typename Callback>
+  int32_t run(int32_t, size_t, StringView, Callback&) const;
+};
+
+MultiPatternMatcher::MultiPatternMatcher(const std::vector<String>& patterns) {
+  std::fill(classes, classes + 256, 0);
+  for (const String& pattern : patterns) {
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      uint8_t& cls = classes[static_cast<unsigned char>(pattern[i])];
+      if (cls == 0) {
+        cls = static_cast<uint8_t>(alphabet++);
+      }
+    }
+  }
+  // trie
+  transitions.assign(alphabet, -1);
+  std::vector<std::vector<int32_t>> ending(1);
+  lengths.resize(patterns.size());
+  for (size_t p = 0; p < patterns.size(); ++p) {
+    lengths[p] = patterns[p].size();
+    if (patterns[p].empty()) {
+      continue;
+    }
+    int32_t state = 0;
+    for (size_t i = 0; i < patterns[p].size(); ++i) {
+      size_t edge = state * alphabet + classes[static_cast<unsigned char>(patterns[p][i])];
+      if (transitions[edge] == -1) {
+        transitions[edge] = static_cast<int32_t>(ending.size());
+        ending.emplace_back();
+        transitions.resize(transitions.size() + alphabet, -1);
+      }
+      state = transitions[edge];
+    }
+    ending[state].push_back(static_cast<int32_t>(p));
+  }
+  size_t count = ending.size();
+  ends.assign(1, 0);
+  for (size_t s = 0; s < count; ++s) {
+    ends_patterns.insert(ends_patterns.end(), ending[s].begin(), ending[s].end());
+    ends.push_back(static_cast<int32_t>(ends_patterns.size()));
+  }
+  // suffix links in BFS order, missing edges are completed from the link
+  std::vector<int32_t> link(count, 0);
+  output.assign(count, -1);
+  next_output.assign(count, -1);
+  std::vector<int32_t> queue(1, 0);
+  for (size_t head = 0; head < queue.size(); ++head) {
+    int32_t s = queue[head];
+    output[s] = ends[s] != ends[s + 1] ? s : output[link[s]];
+    if (s != 0) {
+      next_output[s] = output[link[s]];
+    }
+    for (size_t c = 0; c < alphabet; ++c) {
+      int32_t& target = transitions[s * alphabet + c];
+      int32_t fallback = s == 0 ? 0 : transitions[link[s] * alphabet + c];
+      if (target == -1) {
+        target = fallback;
+      } else {
+        link[target] = fallback;
+        queue.push_back(target);
+      }
+    }
+  }
+  output[0] = -1;
+}
+
+size_t MultiPatternMatcher::patterns() const {
+  return lengths.size();
+}
+
+size_t MultiPatternMatcher::states() const {
+  return output.size();
+}
+
+template<typename Callback>
+int32_t MultiPatternMatcher::run(int32_t state, size_t offset, StringView text, Callback& callback) const {
+  const int32_t* table = transitions.data();
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+  for (size_t i = 0; i < text.size(); ++i) {
+    state = table[state * alphabet + classes[bytes[i]]];
+    for (int32_t s = output[state]; s != -1; s = next_output[s]) {
+      for (int32_t k = ends[s]; k < ends[s + 1]; ++k) {
+        size_t pattern = ends_patterns[k];
+        callback(Match{pattern, offset + i + 1 - lengths[pattern]});
+      }
+    }
+  }
+  return state;
+}
+
+template<typename Callback>
+void MultiPatternMatcher::scan(StringView text, Callback callback) const {
+  run(0, 0, text, callback);
+}
+
+std::vector<MultiPatternMatcher::Match> MultiPatternMatcher::find_all(StringView text) const {
+  std::vector<Match> matches;
+  scan(text, [&matches](const Match& match) {
+    matches.push_back(match);
+  });
+  return matches;
+}
+
+MultiPatternMatcher::Scanner MultiPatternMatcher::scanner() const {
+  return Scanner(*this);
+}
+
+MultiPatternMatcher::Scanner::Scanner(const MultiPatternMatcher& matcher) : matcher(&matcher) {}
+
+template<typename Callback>
+void MultiPatternMatcher::Scanner::feed(StringView chunk, Callback callback) {
+  state = matcher->run(state, offset, chunk, callback);
+  offset += chunk.size();
+}
+
+void MultiPatternMatcher::Scanner::reset() {
+  state = 0;
+  offset = 0;
+}
+
+size_t MultiPatternMatcher::Scanner::position() const {
+  return offset;
+}
+
+#endif /* multisearch_h */
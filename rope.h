@@ -0,0 +1,278 @@
+#ifndef rope_h
+#define rope_h
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "string.h"
+
+// Immutable balanced tree of String chunks. Leaves reference ranges of
+// shared chunks, so concatenation, insertion, erasure and substr copy no
+// characters, they only rebuild O(log n) nodes. Internal nodes are kept
+// AVL-balanced by height.
+class Rope {
+ public:
+  Rope ();
+
+  Rope (const char*);
+
+  Rope (StringView);
+
+  Rope (const String&);
+
+  Rope (String&&);
+
+  size_t length() const;
+
+  size_t size() const;
+
+  bool empty() const;
+
+  int height() const;
+
+  char operator[](size_t) const;
+
+  Rope& operator+=(const Rope&);
+
+  Rope substr(size_t, size_t) const;
+
+  void insert(size_t, const Rope&);
+
+  void erase(size_t, size_t);
+
+  template<typename Callback>
+  void for_each_chunk(Callback) const;
+
+  String flatten() const;
+
+  friend std::ostream& operator<<(std::ostream&, const Rope&);
+ private:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+  struct Node {
+    std::shared_ptr<const String> chunk;
+    size_t offset = 0;
+    NodePtr left;
+    NodePtr right;
+    size_t sz = 0;
+    int height = 0;
+  };
+
+  // leaves this short are merged into one chunk instead of being joined
+  static const size_t kSmallLeaf = 64;
+
+  NodePtr root;
+
+  explicit Rope (NodePtr);
+
+  static int height(const NodePtr&);
+
+  static NodePtr make_leaf(std::shared_ptr<const String>, size_t, size_t);
+
+  static NodePtr make_node(NodePtr, NodePtr);
+
+  static NodePtr balance(NodePtr, NodePtr);
+
+  static NodePtr join(NodePtr, NodePtr);
+
+  static NodePtr slice(const NodePtr&, size_t, size_t);
+};
+
+Rope operator+(const Rope& rope1, const Rope& rope2);
+
+Rope::Rope() {}
+
+Rope::Rope(const char* str) : Rope(String(str)) {}
+
+Rope::Rope(StringView view) : Rope(String(view)) {}
+
+Rope::Rope(const String& str) : Rope(String(str)) {}
+
+Rope::Rope(String&& str) {
+  size_t sz = str.size();
+  root = make_leaf(std::make_shared<const String>(std::move(str)), 0, sz);
+}
+
+Rope::Rope(NodePtr node) : root(std::move(node)) {}
+
+size_t Rope::length() const {
+  return root ? root->sz : 0;
+}
+
+size_t Rope::size() const {
+  return length();
+}
+
+bool Rope::empty() const {
+  return length() == 0;
+}
+
+int Rope::height() const {
+  return height(root);
+}
+
+char Rope::operator[](size_t index) const {
+  const Node* node = root.get();
+  while (!node->chunk) {
+    if (index < node->left->sz) {
+      node = node->left.get();
+    } else {
+      index -= node->left->sz;
+      node = node->right.get();
+    }
+  }
+  return (*node->chunk)[node->offset + index];
+}
+
+Rope& Rope::operator+=(const Rope& rope) {
+  root = join(root, rope.root);
+  return *this;
+}
+
+Rope operator+(const Rope& rope1, const Rope& rope2) {
+  Rope res = rope1;
+  res += rope2;
+  return res;
+}
+
+// count is cut at the end of the rope
+Rope Rope::substr(size_t start, size_t count) const {
+  start = std::min(start, length());
+  return Rope(slice(root, start, std::min(count, length() - start)));
+}
+
+void Rope::insert(size_t pos, const Rope& rope) {
+  pos = std::min(pos, length());
+  root = join(join(slice(root, 0, pos), rope.root), slice(root, pos, length() - pos));
+}
+
+void Rope::erase(size_t pos, size_t count) {
+  pos = std::min(pos, length());
+  count = std::min(count, length() - pos);
+  root = join(slice(root, 0, pos), slice(root, pos + count, length() - pos - count));
+}
+
+template<typename Callback>
+void Rope::for_each_chunk(Callback callback) const {
+  std::vector<const Node*> stack;
+  if (root) {
+    stack.push_back(root.get());
+  }
+  while (!stack.empty()) {
+    const Node* node = stack.back();
+    stack.pop_back();
+    if (node->chunk) {
+      callback(node->chunk->slice(node->offset, node->sz));
+    } else {
+      stack.push_back(node->right.get());
+      stack.push_back(node->left.get());
+    }
+  }
+}
+
+String Rope::flatten() const {
+  String res;
+  res.reserve(length());
+  for_each_chunk([&res](StringView chunk) {
+    res.append(chunk);
+  });
+  return res;
+}
+
+std::ostream& operator<<(std::ostream& stream, const Rope& rope) {
+  rope.for_each_chunk([&stream](StringView chunk) {
+    stream << chunk;
+  });
+  return stream;
+}
+
+int Rope::height(const NodePtr& node) {
+  return node ? node->height : -1;
+}
+
+Rope::NodePtr Rope::make_leaf(std::shared_ptr<const String> chunk, size_t offset, size_t count) {
+  if (count == 0) {
+    return nullptr;
+  }
+  auto node = std::make_shared<Node>();
+  node->chunk = std::move(chunk);
+  node->offset = offset;
+  node->sz = count;
+  return node;
+}
+
+Rope::NodePtr Rope::make_node(NodePtr left, NodePtr right) {
+  auto node = std::make_shared<Node>();
+  node->sz = left->sz + right->sz;
+  node->height = std::max(left->height, right->height) + 1;
+  node->left = std::move(left);
+  node->right = std::move(right);
+  return node;
+}
+
+// Heights of left and right differ by at most two, one or two
+// rotations bring the difference back to one
+Rope::NodePtr Rope::balance(NodePtr left, NodePtr right) {
+  if (height(left) > height(right) + 1) {
+    if (height(left->left) >= height(left->right)) {
+      return make_node(left->left, make_node(left->right, right));
+    }
+    const NodePtr& middle = left->right;
+    return make_node(make_node(left->left, middle->left), make_node(middle->right, right));
+  }
+  if (height(right) > height(left) + 1) {
+    if (height(right->right) >= height(right->left)) {
+      return make_node(make_node(left, right->left), right->right);
+    }
+    const NodePtr& middle = right->left;
+    return make_node(make_node(left, middle->left), make_node(middle->right, right->right));
+  }
+  return make_node(left, right);
+}
+
+// Descends along the spine of the higher tree until the heights match,
+// so the cost is proportional to the difference of heights
+Rope::NodePtr Rope::join(NodePtr left, NodePtr right) {
+  if (!left) {
+    return right;
+  }
+  if (!right) {
+    return left;
+  }
+  if (left->chunk && right->chunk && left->sz + right->sz <= kSmallLeaf) {
+    String merged(left->chunk->slice(left->offset, left->sz));
+    merged.append(right->chunk->slice(right->offset, right->sz));
+    return Rope(std::move(merged)).root;
+  }
+  if (height(left) > height(right) + 1) {
+    return balance(left->left, join(left->right, right));
+  }
+  if (height(right) > height(left) + 1) {
+    return balance(join(left, right->left), right->right);
+  }
+  return make_node(left, right);
+}
+
+Rope::NodePtr Rope::slice(const NodePtr& node, size_t start, size_t count) {
+  if (!node || count == 0) {
+    return nullptr;
+  }
+  if (start == 0 && count == node->sz) {
+    return node;
+  }
+  if (node->chunk) {
+    return make_leaf(node->chunk, node->offset + start, count);
+  }
+  size_t left_sz = node->left->sz;
+  if (start + count <= left_sz) {
+    return slice(node->left, start, count);
+  }
+  if (start >= left_sz) {
+    return slice(node->right, start - left_sz, count);
+  }
+  return join(slice(node->left, start, left_sz - start),
+              slice(node->right, 0, start + count - left_sz));
+}
+
+#endif /* rope_h */
@@ -4,17 +4,92 @@
 #include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define STRING_SIMD_SEARCH
+#endif
+
+// glibc's vectorized memrchr, declared under _GNU_SOURCE
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+#define STRING_MEMRCHR
+#endif
+
+// Non-owning pointer and length into characters that live elsewhere,
+// e.g. in a String. Slicing a view never allocates.
+class StringView {
+ public:
+  StringView ();
+  
+  StringView (const char*);
+  
+  StringView (const char*, size_t);
+  
+  size_t length() const;
+  
+  size_t size() const;
+  
+  bool empty() const;
+  
+  const char* data() const;
+  
+  const char& operator[](size_t) const;
+  
+  const char& front() const;
+  
+  const char& back() const;
+  
+  size_t find(StringView) const;
+  
+  size_t find(StringView, size_t) const;
+  
+  size_t rfind(StringView) const;
+  
+  size_t rfind(StringView, size_t) const;
+  
+  StringView substr(size_t, size_t) const;
+  
+  void remove_prefix(size_t);
+  
+  void remove_suffix(size_t);
+  
+  int compare(StringView) const;
+  
+  friend std::ostream& operator<<(std::ostream&, StringView);
+ private:
+  const char* ptr = "";
+  size_t sz = 0;
+};
+
+bool operator==(StringView view1, StringView view2);
+
+bool operator!=(StringView view1, StringView view2);
+
+bool operator<(StringView view1, StringView view2);
+
+bool operator>(StringView view1, StringView view2);
+
+bool operator<=(StringView view1, StringView view2);
+
+bool operator>=(StringView view1, StringView view2);
 
 class String {
  public:
   String (const char*);
   
+  explicit String (StringView);
+  
   String (size_t, const char&);
   
   String ();
     
   String (const String&);
   
+  String (String&&) noexcept;
+  
   size_t length() const;
   
   void push_back(char);
@@ -29,20 +104,40 @@ class String {
   
   const char& back() const;
   
-  size_t find(const String&) const;
+  size_t find(StringView) const;
+  
+  size_t find(StringView, size_t) const;
   
-  size_t rfind(const String&) const;
+  size_t rfind(StringView) const;
+  
+  size_t rfind(StringView, size_t) const;
   
   String substr(size_t, size_t) const;
   
+  StringView slice(size_t, size_t) const;
+  
+  operator StringView() const;
+  
+  int compare(StringView) const;
+  
   bool empty() const;
   
   void clear();
   
   void shrink_to_fit();
   
+  void reserve(size_t);
+  
+  void resize(size_t, char = '\0');
+  
+  String& append(const char*, size_t);
+  
+  String& append(StringView);
+  
   String& operator=(const String&);
   
+  String& operator=(String&&) noexcept;
+  
   char& operator[](size_t);
   
   const char& operator[](size_t) const;
@@ -63,9 +158,23 @@ class String {
   
   ~String();
  private:
+  static const size_t kLocalCapacity = 15;
+  
   char* arr = nullptr;
   size_t sz = 0;
-  size_t cap = 0;
+  // Short strings are kept inside the object, cap is only needed on the heap
+  union {
+    size_t cap;
+    char local[kLocalCapacity + 1];
+  };
+  
+  bool is_local() const;
+  
+  void allocate(size_t);
+  
+  void reallocate(size_t);
+  
+  void grow(size_t);
   
   void swap(String&);
   
@@ -85,24 +194,24 @@ bool operator<=(const String& str1, const String& str2);
 bool operator>=(const String& str1, const String& str2);
 
 String::String(const char* str2) {
-  for (size_t i = 0;; ++i) {
-    if (str2[i] == '\0') {
-      break;
-    }
-    sz++;
-    cap++;
-  }
-  arr = new char[sz + 1];
+  allocate(strlen(str2));
   memcpy(arr, str2, sz);
   arr[sz] = '\0';
 }
   
-String::String(size_t n, const char& c) : arr(new char[n + 1]), sz(n), cap(n) {
+String::String(StringView view) {
+  allocate(view.size());
+  memcpy(arr, view.data(), sz);
+  arr[sz] = '\0';
+}
+
+String::String(size_t n, const char& c) {
+  allocate(n);
   memset(arr, c, n);
   arr[n] = '\0';
 }
 
-String::String() : arr(new char[1]) {
+String::String() : arr(local) {
   arr[0] = '\0';
 }
 
@@ -110,6 +219,10 @@ String::String(const String& str2) : String(str2.sz, '\0') {
   memcpy(arr, str2.arr, sz);
 }
 
+String::String(String&& str2) noexcept : String() {
+  swap(str2);
+}
+
 size_t String::length() const {
   return sz;
 }
@@ -142,42 +255,362 @@ const char& String::back() const {
   return arr[sz - 1];
 }
 
-size_t String::find(const String& substring) const {
-  for (size_t i = 0; i <= length() - substring.length(); ++i) {
-    bool is_qual = true;
-    for (size_t j = i; j < i + substring.length(); ++j) {
-      if (arr[j] != substring[j - i]) {
-        is_qual = false;
-      }
+// Needles from this length on are searched with Boyer-Moore-Horspool,
+// shorter ones by filtering candidates on their first and last byte
+const size_t kHorspoolThreshold = 32;
+
+size_t horspool_search(const char* text, size_t n, const char* pattern, size_t m) {
+  size_t shift[256];
+  std::fill(shift, shift + 256, m);
+  for (size_t i = 0; i + 1 < m; ++i) {
+    shift[static_cast<unsigned char>(pattern[i])] = m - 1 - i;
+  }
+  char last = pattern[m - 1];
+  for (size_t i = 0; i + m <= n;) {
+    char c = text[i + m - 1];
+    if (c == last && memcmp(text + i, pattern, m - 1) == 0) {
+      return i;
     }
-    if (is_qual) {
+    i += shift[static_cast<unsigned char>(c)];
+  }
+  return n;
+}
+
+// Mirrored Horspool: the window moves left and shifts by the first byte
+size_t horspool_search_backward(const char* text, size_t n, const char* pattern, size_t m) {
+  size_t shift[256];
+  std::fill(shift, shift + 256, m);
+  for (size_t i = m - 1; i > 0; --i) {
+    shift[static_cast<unsigned char>(pattern[i])] = i;
+  }
+  char first = pattern[0];
+  for (size_t i = n - m;;) {
+    char c = text[i];
+    if (c == first && memcmp(text + i + 1, pattern + 1, m - 1) == 0) {
       return i;
     }
+    size_t step = shift[static_cast<unsigned char>(c)];
+    if (i < step) {
+      return n;
+    }
+    i -= step;
+  }
+}
+
+// memchr (vectorized by libc) for the first byte, then a full compare
+size_t scalar_search(const char* text, size_t n, const char* pattern, size_t m, size_t from) {
+  while (from + m <= n) {
+    const char* found = static_cast<const char*>(memchr(text + from, pattern[0], n - m + 1 - from));
+    if (found == nullptr) {
+      return n;
+    }
+    from = found - text;
+    if (memcmp(found + 1, pattern + 1, m - 1) == 0) {
+      return from;
+    }
+    ++from;
+  }
+  return n;
+}
+
+// Last occurrence of c among the first count bytes
+const char* last_byte(const char* text, size_t count, char c) {
+#ifdef STRING_MEMRCHR
+  return static_cast<const char*>(memrchr(text, c, count));
+#else
+  for (size_t i = count; i > 0; --i) {
+    if (text[i - 1] == c) {
+      return text + i - 1;
+    }
   }
-  return length();
+  return nullptr;
+#endif
 }
 
-size_t String::rfind(const String& substring) const {
-  for (int i = static_cast<int>(length() - substring.length()); i >= 0; --i) {
-    bool is_qual = true;
-    for (int j = i; j < i + static_cast<int>(substring.length()); ++j) {
-      if (arr[j] != substring[j - i]) {
-        is_qual = false;
+// Mirror of scalar_search over the window starts below count
+size_t scalar_search_backward(const char* text, size_t n, const char* pattern, size_t m, size_t count) {
+  while (count > 0) {
+    const char* found = last_byte(text, count, pattern[0]);
+    if (found == nullptr) {
+      return n;
+    }
+    count = found - text;
+    if (memcmp(found + 1, pattern + 1, m - 1) == 0) {
+      return count;
+    }
+  }
+  return n;
+}
+
+#ifdef STRING_SIMD_SEARCH
+// Compares the first and the last byte of the needle with 16 (32) windows at
+// once and checks the rest only where both match
+size_t sse2_search(const char* text, size_t n, const char* pattern, size_t m) {
+  const __m128i first = _mm_set1_epi8(pattern[0]);
+  const __m128i last = _mm_set1_epi8(pattern[m - 1]);
+  size_t i = 0;
+  for (; i + m + 15 <= n; i += 16) {
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                                                    _mm_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      unsigned bit = __builtin_ctz(mask);
+      if (memcmp(text + i + bit + 1, pattern + 1, m - 2) == 0) {
+        return i + bit;
       }
+      mask &= mask - 1;
     }
-    if (is_qual) {
-      return i;
+  }
+  return scalar_search(text, n, pattern, m, i);
+}
+
+__attribute__((target("avx2")))
+size_t avx2_search(const char* text, size_t n, const char* pattern, size_t m) {
+  const __m256i first = _mm256_set1_epi8(pattern[0]);
+  const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+  size_t i = 0;
+  for (; i + m + 31 <= n; i += 32) {
+    __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+    __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                                                          _mm256_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      unsigned bit = __builtin_ctz(mask);
+      if (memcmp(text + i + bit + 1, pattern + 1, m - 2) == 0) {
+        return i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return scalar_search(text, n, pattern, m, i);
+}
+
+// The same filters over blocks taken from the end, candidates in a block
+// are checked from the highest bit down
+size_t sse2_search_backward(const char* text, size_t n, const char* pattern, size_t m) {
+  const __m128i first = _mm_set1_epi8(pattern[0]);
+  const __m128i last = _mm_set1_epi8(pattern[m - 1]);
+  size_t count = n - m + 1;
+  for (; count >= 16; count -= 16) {
+    size_t i = count - 16;
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                                                    _mm_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      unsigned bit = 31 - __builtin_clz(mask);
+      if (memcmp(text + i + bit + 1, pattern + 1, m - 2) == 0) {
+        return i + bit;
+      }
+      mask ^= 1u << bit;
+    }
+  }
+  return scalar_search_backward(text, n, pattern, m, count);
+}
+
+__attribute__((target("avx2")))
+size_t avx2_search_backward(const char* text, size_t n, const char* pattern, size_t m) {
+  const __m256i first = _mm256_set1_epi8(pattern[0]);
+  const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+  size_t count = n - m + 1;
+  for (; count >= 32; count -= 32) {
+    size_t i = count - 32;
+    __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+    __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                                                          _mm256_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      unsigned bit = 31 - __builtin_clz(mask);
+      if (memcmp(text + i + bit + 1, pattern + 1, m - 2) == 0) {
+        return i + bit;
+      }
+      mask ^= 1u << bit;
     }
   }
-  return length();
+  return scalar_search_backward(text, n, pattern, m, count);
 }
+#endif
 
-String String::substr(size_t start, size_t count) const {
-  String res(count, '\0');
-  for (size_t i = start; i < start + count; i++) {
-    res[i - start] = arr[i];
+// Position of the first occurrence of pattern in text, n if there is none
+size_t search_forward(const char* text, size_t n, const char* pattern, size_t m) {
+  if (m == 0) {
+    return 0;
   }
-  return res;
+  if (m > n) {
+    return n;
+  }
+  if (m == 1) {
+    const char* found = static_cast<const char*>(memchr(text, pattern[0], n));
+    return found == nullptr ? n : found - text;
+  }
+  if (m >= kHorspoolThreshold) {
+    return horspool_search(text, n, pattern, m);
+  }
+#ifdef STRING_SIMD_SEARCH
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2 ? avx2_search(text, n, pattern, m) : sse2_search(text, n, pattern, m);
+#else
+  return scalar_search(text, n, pattern, m, 0);
+#endif
+}
+
+// Position of the last occurrence of pattern in text, n if there is none
+size_t search_backward(const char* text, size_t n, const char* pattern, size_t m) {
+  if (m == 0 || m > n) {
+    return n;
+  }
+  if (m == 1) {
+    const char* found = last_byte(text, n, pattern[0]);
+    return found == nullptr ? n : found - text;
+  }
+  if (m >= kHorspoolThreshold) {
+    return horspool_search_backward(text, n, pattern, m);
+  }
+#ifdef STRING_SIMD_SEARCH
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2 ? avx2_search_backward(text, n, pattern, m) : sse2_search_backward(text, n, pattern, m);
+#else
+  return scalar_search_backward(text, n, pattern, m, n - m + 1);
+#endif
+}
+
+StringView::StringView() {}
+
+StringView::StringView(const char* str) : ptr(str), sz(strlen(str)) {}
+
+StringView::StringView(const char* str, size_t count) : ptr(str), sz(count) {}
+
+size_t StringView::length() const {
+  return sz;
+}
+
+size_t StringView::size() const {
+  return sz;
+}
+
+bool StringView::empty() const {
+  return sz == 0;
+}
+
+const char* StringView::data() const {
+  return ptr;
+}
+
+const char& StringView::operator[](size_t index) const {
+  return ptr[index];
+}
+
+const char& StringView::front() const {
+  return ptr[0];
+}
+
+const char& StringView::back() const {
+  return ptr[sz - 1];
+}
+
+size_t StringView::find(StringView substring) const {
+  return search_forward(ptr, sz, substring.ptr, substring.sz);
+}
+
+size_t StringView::find(StringView substring, size_t pos) const {
+  if (pos > sz) {
+    return sz;
+  }
+  return pos + search_forward(ptr + pos, sz - pos, substring.ptr, substring.sz);
+}
+
+size_t StringView::rfind(StringView substring) const {
+  return search_backward(ptr, sz, substring.ptr, substring.sz);
+}
+
+// Last occurrence that starts at or before pos
+size_t StringView::rfind(StringView substring, size_t pos) const {
+  if (pos >= sz || substring.sz > sz - pos) {
+    return rfind(substring);
+  }
+  size_t found = search_backward(ptr, pos + substring.sz, substring.ptr, substring.sz);
+  return found == pos + substring.sz ? sz : found;
+}
+
+// count is cut at the end of the view
+StringView StringView::substr(size_t start, size_t count) const {
+  start = std::min(start, sz);
+  return StringView(ptr + start, std::min(count, sz - start));
+}
+
+void StringView::remove_prefix(size_t count) {
+  ptr += count;
+  sz -= count;
+}
+
+void StringView::remove_suffix(size_t count) {
+  sz -= count;
+}
+
+int StringView::compare(StringView view) const {
+  int res = memcmp(ptr, view.ptr, std::min(sz, view.sz));
+  if (res != 0) {
+    return res;
+  }
+  return sz == view.sz ? 0 : (sz < view.sz ? -1 : 1);
+}
+
+bool operator==(StringView view1, StringView view2) {
+  return view1.size() == view2.size() && memcmp(view1.data(), view2.data(), view1.size()) == 0;
+}
+
+bool operator!=(StringView view1, StringView view2) {
+  return !(view1 == view2);
+}
+
+bool operator<(StringView view1, StringView view2) {
+  return view1.compare(view2) < 0;
+}
+
+bool operator>(StringView view1, StringView view2) {
+  return view1.compare(view2) > 0;
+}
+
+bool operator<=(StringView view1, StringView view2) {
+  return view1.compare(view2) <= 0;
+}
+
+bool operator>=(StringView view1, StringView view2) {
+  return view1.compare(view2) >= 0;
+}
+
+std::ostream& operator<<(std::ostream& stream, StringView view) {
+  stream.write(view.ptr, view.sz);
+  return stream;
+}
+
+size_t String::find(StringView substring) const {
+  return StringView(*this).find(substring);
+}
+
+size_t String::find(StringView substring, size_t pos) const {
+  return StringView(*this).find(substring, pos);
+}
+
+size_t String::rfind(StringView substring) const {
+  return StringView(*this).rfind(substring);
+}
+
+size_t String::rfind(StringView substring, size_t pos) const {
+  return StringView(*this).rfind(substring, pos);
+}
+
+String String::substr(size_t start, size_t count) const {
+  return String(slice(start, count));
+}
+
+StringView String::slice(size_t start, size_t count) const {
+  return StringView(*this).substr(start, count);
+}
+
+String::operator StringView() const {
+  return StringView(arr, sz);
 }
 
 bool String::empty() const {
@@ -200,29 +633,70 @@ String& String::operator=(const String& str2) {
   return *this;
 }
 
-bool operator<(const String& str1, const String& str2) {
-  for (size_t i = 0; i < str1.length() && i < str2.length(); ++i) {
-    if (str1[i] != str2[i]) {
-      return str1[i] < str2[i];
+String& String::operator=(String&& str2) noexcept {
+  swap(str2);
+  return *this;
+}
+
+void String::reserve(size_t new_capacity) {
+  if (new_capacity > capacity()) {
+    reallocate(new_capacity);
+  }
+}
+
+void String::resize(size_t new_sz, char c) {
+  if (new_sz > sz) {
+    grow(new_sz);
+    memset(arr + sz, c, new_sz - sz);
+  }
+  sz = new_sz;
+  arr[sz] = '\0';
+}
+
+// str2 may point into this string, so the old buffer is released
+// only after the new characters are copied
+String& String::append(const char* str2, size_t count) {
+  if (sz + count > capacity()) {
+    size_t new_capacity = std::max(sz + count, capacity() * 2);
+    char* temp = new char[new_capacity + 1];
+    memcpy(temp, arr, sz);
+    memcpy(temp + sz, str2, count);
+    if (!is_local()) {
+      delete[] arr;
     }
+    arr = temp;
+    cap = new_capacity;
+  } else {
+    memmove(arr + sz, str2, count);
   }
-  return str1.length() < str2.length();
+  sz += count;
+  arr[sz] = '\0';
+  return *this;
+}
+
+int String::compare(StringView view) const {
+  return StringView(*this).compare(view);
+}
+
+bool operator<(const String& str1, const String& str2) {
+  return str1.compare(str2) < 0;
 }
 
 bool operator>=(const String& str1, const String& str2) {
-  return !(str1 < str2);
+  return str1.compare(str2) >= 0;
 }
 
 bool operator>(const String& str1, const String& str2) {
-  return str2 < str1;
+  return str1.compare(str2) > 0;
 }
 
 bool operator<=(const String& str1, const String& str2) {
-  return !(str1 > str2);
+  return str1.compare(str2) <= 0;
 }
 
+// Sizes first, so strings of different length never touch their data
 bool operator==(const String& str1, const String& str2) {
-  return !(str1 < str2 || str1 > str2);
+  return str1.size() == str2.size() && memcmp(str1.data(), str2.data(), str1.size()) == 0;
 }
 
 bool operator!=(const String& str1, const String& str2) {
@@ -237,20 +711,12 @@ const char& String::operator[](size_t index) const {
   return arr[index];
 }
 
+String& String::append(StringView view) {
+  return append(view.data(), view.size());
+}
+
 String& String::operator+=(const String& str2) {
-  size_t new_sz = length() + str2.length();
-  if (new_sz >= cap) {
-    char* temp = new char[new_sz + 1];
-    memcpy(temp, arr, sz);
-    std::swap(temp, arr);
-    delete[] temp;
-    sz = new_sz;
-    cap = new_sz;
-  }
-  for (size_t i = new_sz - str2.length(); i <= new_sz; ++i) {
-    arr[i] = str2[i - (new_sz - str2.length())];
-  }
-  return *this;
+  return append(str2.arr, str2.sz);
 }
 
 String& String::operator+=(const char& c) {
@@ -266,13 +732,16 @@ String operator+(const String& str1, const char& c) {
 
 String operator+(const char& c, const String& str1) {
   String res;
+  res.reserve(str1.length() + 1);
   res += c;
   res += str1;
   return res;
 }
 
 String operator+(const String& str1, const String& str2) {
-  String res = str1;
+  String res;
+  res.reserve(str1.length() + str2.length());
+  res += str1;
   res += str2;
   return res;
 }
@@ -291,22 +760,69 @@ std::ostream& operator<<(std::ostream& stream, const String& string) {
 }
 
 std::istream& operator>>(std::istream& stream, String& string) {
-  string  = "";
+  string.clear();
+  char buffer[256];
+  size_t count = 0;
   char value;
   while (stream.get(value) && !std::isspace(value)) {
-    string += value;
+    buffer[count++] = value;
+    if (count == sizeof(buffer)) {
+      string.append(buffer, count);
+      count = 0;
+    }
   }
+  string.append(buffer, count);
   return stream;
 }
 
 String::~String() {
-  delete[] arr;
+  if (!is_local()) {
+    delete[] arr;
+  }
+}
+
+bool String::is_local() const {
+  return arr == local;
+}
+
+void String::allocate(size_t n) {
+  sz = n;
+  if (n <= kLocalCapacity) {
+    arr = local;
+  } else {
+    arr = new char[n + 1];
+    cap = n;
+  }
+}
+
+void String::reallocate(size_t new_capacity) {
+  char* temp = new char[new_capacity + 1];
+  memcpy(temp, arr, sz + 1);
+  if (!is_local()) {
+    delete[] arr;
+  }
+  arr = temp;
+  cap = new_capacity;
 }
 
+// A local buffer can't change owner by swapping pointers, its bytes move instead
 void String::swap(String &str2) {
-  std::swap(arr, str2.arr);
+  if (!is_local() && !str2.is_local()) {
+    std::swap(arr, str2.arr);
+    std::swap(cap, str2.cap);
+  } else if (is_local() && str2.is_local()) {
+    std::swap(local, str2.local);
+  } else {
+    String& short_str = is_local() ? *this : str2;
+    String& long_str = is_local() ? str2 : *this;
+    char* heap_arr = long_str.arr;
+    size_t heap_cap = long_str.cap;
+    memcpy(long_str.local, short_str.local, kLocalCapacity + 1);
+    long_str.arr = long_str.local;
+    short_str.arr = heap_arr;
+    short_str.cap = heap_cap;
+  }
   std::swap(sz, str2.sz);
-  std::swap(cap, str2.cap);
 }
 
 size_t String::size() const {
@@ -314,16 +830,117 @@ size_t String::size() const {
 }
 
 size_t String::capacity() const {
-  return cap;
+  return is_local() ? kLocalCapacity : cap;
+}
+
+// At least doubles the capacity, so a series of appends copies every
+// character a constant number of times on average
+void String::grow(size_t new_sz) {
+  if (new_sz > capacity()) {
+    reallocate(std::max(new_sz, capacity() * 2));
+  }
 }
 
 void String::expansion_cap() {
-  if (sz < cap) return;
-  size_t new_capacity = std::max(cap, static_cast<size_t>(5)) * 2;
-  String new_str(new_capacity, '\0');
-  memcpy(new_str.arr, arr, sz);
-  new_str.sz = sz;
-  swap(new_str);
+  grow(sz + 1);
+}
+
+// Appended pieces are copied into chunks that are never reallocated,
+// build() then copies them into a String with one allocation.
+class StringBuilder {
+ public:
+  StringBuilder& operator+=(const String&);
+  
+  StringBuilder& operator+=(const char*);
+  
+  StringBuilder& operator+=(char);
+  
+  StringBuilder& append(const char*, size_t);
+  
+  size_t size() const;
+  
+  String build() const;
+  
+  void clear();
+ private:
+  static const size_t kMinChunk = 256;
+  
+  std::vector<String> chunks;
+  size_t sz = 0;
+};
+
+StringBuilder& StringBuilder::operator+=(const String& str) {
+  return append(str.data(), str.size());
+}
+
+StringBuilder& StringBuilder::operator+=(const char* str) {
+  return append(str, strlen(str));
+}
+
+StringBuilder& StringBuilder::operator+=(char c) {
+  return append(&c, 1);
+}
+
+StringBuilder& StringBuilder::append(const char* str, size_t count) {
+  if (chunks.empty() || chunks.back().capacity() - chunks.back().size() < count) {
+    size_t chunk = chunks.empty() ? kMinChunk : chunks.back().capacity() * 2;
+    chunks.emplace_back();
+    chunks.back().reserve(std::max(chunk, count));
+  }
+  chunks.back().append(str, count);
+  sz += count;
+  return *this;
+}
+
+size_t StringBuilder::size() const {
+  return sz;
+}
+
+String StringBuilder::build() const {
+  String res;
+  res.reserve(sz);
+  for (const String& chunk : chunks) {
+    res += chunk;
+  }
+  return res;
+}
+
+void StringBuilder::clear() {
+  chunks.clear();
+  sz = 0;
+}
+
+// Processes the data eight bytes at a time, the tail byte by byte
+size_t hashBytes(const char* data, size_t size) {
+  uint64_t result = 0xcbf29ce484222325ULL ^ size;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    result = (result ^ word) * 0x9e3779b97f4a7c15ULL;
+    result ^= result >> 29;
+  }
+  for (; i < size; ++i) {
+    result = (result ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+  }
+  result ^= result >> 32;
+  return static_cast<size_t>(result);
+}
+
+namespace std {
+template<>
+struct hash<String> {
+  size_t operator()(const String& string) const {
+    return hashBytes(string.data(), string.size());
+  }
+};
+
+template<>
+struct hash<StringView> {
+  size_t operator()(StringView view) const {
+    return hashBytes(view.data(), view.size());
+  }
+};
 }
 
 #endif
\ No newline at end of file
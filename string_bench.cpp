@@ -0,0 +1,403 @@
+// Benchmarks for String: append loops, search, slicing, comparisons and
+// stream input over a sweep of lengths. Reports ns/op, bytes/s and heap
+// allocations (count and bytes) per op, counted by replacing the global
+// operator new.
+//
+//   g++ -std=c++17 -O2 string_bench.cpp -o string_bench
+//   ./string_bench [--filter text] [--min-time ms] [--json out.json] [--baseline old.json]
+//
+// With --baseline every result is printed next to the matching result of an
+// earlier --json run, with the time ratio (below 1 is faster).
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "string.h"
+
+std::atomic<size_t> allocation_count(0);
+std::atomic<size_t> allocation_bytes(0);
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  void* result = malloc(size == 0 ? 1 : size);
+  if (result == nullptr) {
+    abort();
+  }
+  return result;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+// Keeps the compiler from dropping a computation whose result is unused
+template<typename T>
+void keep(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T* sink;
+  sink = &value;
+#endif
+}
+
+struct Result {
+  std::string name;
+  size_t length = 0;
+  double ns_per_op = 0;
+  double bytes_per_second = 0;
+  double allocs_per_op = 0;
+  double allocated_bytes_per_op = 0;
+};
+
+// One benchmark: run(length) performs ops() operations over bytes() bytes
+struct Benchmark {
+  const char* name;
+  size_t (*ops)(size_t);
+  size_t (*bytes)(size_t);
+  void (*run)(size_t);
+};
+
+size_t one(size_t) {
+  return 1;
+}
+
+size_t per_byte(size_t length) {
+  return length;
+}
+
+size_t half(size_t length) {
+  return length / 2;
+}
+
+size_t per_chunk(size_t length) {
+  return (length + 15) / 16;
+}
+
+// For view-only work that touches no characters; bytes/s is shown as n/a
+size_t none(size_t) {
+  return 0;
+}
+
+const char kChunk[] = "0123456789abcdef";
+
+String make_text(size_t length) {
+  String text(length, 'a');
+  for (size_t i = 0; i < length; ++i) {
+    text[i] = static_cast<char>('a' + (i * 7 + i / 13) % 26);
+  }
+  return text;
+}
+
+void bench_push_back(size_t length) {
+  String str;
+  for (size_t i = 0; i < length; ++i) {
+    str.push_back('x');
+  }
+  keep(str.data()[0]);
+}
+
+void bench_append_char(size_t length) {
+  String str;
+  for (size_t i = 0; i < length; ++i) {
+    str += 'x';
+  }
+  keep(str.data()[0]);
+}
+
+void bench_append_chunk(size_t length) {
+  String str;
+  for (size_t i = 0; i < length; i += 16) {
+    str.append(kChunk, 16);
+  }
+  keep(str.data()[0]);
+}
+
+void bench_builder(size_t length) {
+  StringBuilder builder;
+  for (size_t i = 0; i < length; i += 16) {
+    builder.append(kChunk, 16);
+  }
+  String str = builder.build();
+  keep(str.data()[0]);
+}
+
+// Inputs of the read-only benchmarks are built once per length
+struct Inputs {
+  size_t length = SIZE_MAX;
+  String text;
+  String equal;
+  String last_differs;
+  String stream_text;
+};
+
+Inputs inputs;
+
+const Inputs& inputs_for(size_t length) {
+  if (inputs.length != length) {
+    inputs.length = length;
+    inputs.text = make_text(length);
+    inputs.equal = inputs.text;
+    inputs.last_differs = inputs.text;
+    if (length > 0) {
+      inputs.last_differs[length - 1] = '#';
+    }
+    inputs.stream_text = inputs.text;
+    inputs.stream_text += ' ';
+  }
+  return inputs;
+}
+
+// Needles are absent, so every search scans the whole text
+void bench_find_short(size_t length) {
+  keep(inputs_for(length).text.find("#ab#"));
+}
+
+void bench_find_long(size_t length) {
+  static const String needle = String(60, 'q') + String("#ab#");
+  keep(inputs_for(length).text.find(needle));
+}
+
+void bench_rfind_short(size_t length) {
+  keep(inputs_for(length).text.rfind("#ab#"));
+}
+
+void bench_substr(size_t length) {
+  String part = inputs_for(length).text.substr(length / 4, length / 2);
+  keep(part.data()[0]);
+}
+
+void bench_slice(size_t length) {
+  StringView part = inputs_for(length).text.slice(length / 4, length / 2);
+  keep(part);
+}
+
+void bench_equal(size_t length) {
+  const Inputs& in = inputs_for(length);
+  keep(in.text == in.equal);
+}
+
+void bench_less(size_t length) {
+  const Inputs& in = inputs_for(length);
+  keep(in.text < in.last_differs);
+}
+
+// Reads straight from the prepared text, so only String allocates
+class ViewBuffer : public std::streambuf {
+ public:
+  explicit ViewBuffer (StringView view) {
+    char* begin = const_cast<char*>(view.data());
+    setg(begin, begin, begin + view.size());
+  }
+};
+
+void bench_stream_input(size_t length) {
+  ViewBuffer buffer(inputs_for(length).stream_text);
+  std::istream stream(&buffer);
+  String str;
+  stream >> str;
+  keep(str.data()[0]);
+}
+
+const Benchmark kBenchmarks[] = {
+  {"push_back", per_byte, per_byte, bench_push_back},
+  {"append_char", per_byte, per_byte, bench_append_char},
+  {"append_chunk", per_chunk, per_byte, bench_append_chunk},
+  {"builder_chunk", per_chunk, per_byte, bench_builder},
+  {"find_short", one, per_byte, bench_find_short},
+  {"find_long", one, per_byte, bench_find_long},
+  {"rfind_short", one, per_byte, bench_rfind_short},
+  {"substr", one, half, bench_substr},
+  {"slice", one, none, bench_slice},
+  {"equal", one, per_byte, bench_equal},
+  {"less", one, per_byte, bench_less},
+  {"stream_input", one, per_byte, bench_stream_input},
+};
+
+const size_t kLengths[] = {8, 64, 1024, 16384, 1 << 20};
+
+// Doubles the repetitions until a batch takes at least min_time,
+// then reports the best of three batches
+Result measure(const Benchmark& bench, size_t length, double min_time) {
+  using Clock = std::chrono::steady_clock;
+  bench.run(length);
+  size_t reps = 1;
+  double best = 0;
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  for (int batch = 0; batch < 3;) {
+    size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    size_t bytes_before = allocation_bytes.load(std::memory_order_relaxed);
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < reps; ++i) {
+      bench.run(length);
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    if (elapsed < min_time) {
+      reps *= 2;
+      continue;
+    }
+    double per_rep = elapsed / reps;
+    if (batch == 0 || per_rep < best) {
+      best = per_rep;
+    }
+    allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+    allocated_bytes = allocation_bytes.load(std::memory_order_relaxed) - bytes_before;
+    ++batch;
+  }
+  Result result;
+  result.name = bench.name;
+  result.length = length;
+  double ops = static_cast<double>(std::max(bench.ops(length), static_cast<size_t>(1)));
+  result.ns_per_op = best * 1e9 / ops;
+  result.bytes_per_second = best > 0 ? bench.bytes(length) / best : 0;
+  result.allocs_per_op = allocations / (ops * reps);
+  result.allocated_bytes_per_op = allocated_bytes / (ops * reps);
+  return result;
+}
+
+void write_json(std::ostream& stream, const std::vector<Result>& results) {
+  stream << "[\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    char line[256];
+    snprintf(line, sizeof(line),
+             "  {\"name\": \"%s\", \"length\": %zu, \"ns_per_op\": %.4f, \"bytes_per_second\": %.1f, \"allocs_per_op\": %.4f, \"allocated_bytes_per_op\": %.2f}",
+             r.name.c_str(), r.length, r.ns_per_op, r.bytes_per_second, r.allocs_per_op, r.allocated_bytes_per_op);
+    stream << line << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  stream << "]\n";
+}
+
+// Reads the files written by write_json: one result object per line
+bool json_number(const std::string& line, const char* key, double& value) {
+  std::string pattern = std::string("\"") + key + "\":";
+  size_t pos = line.find(pattern);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  value = strtod(line.c_str() + pos + pattern.size(), nullptr);
+  return true;
+}
+
+bool read_json(const char* path, std::vector<Result>& results) {
+  std::ifstream stream(path);
+  if (!stream) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(stream, line)) {
+    size_t name = line.find("\"name\": \"");
+    if (name == std::string::npos) {
+      continue;
+    }
+    name += 9;
+    Result r;
+    r.name = line.substr(name, line.find('"', name) - name);
+    double length = 0;
+    if (!json_number(line, "length", length) || !json_number(line, "ns_per_op", r.ns_per_op)) {
+      continue;
+    }
+    r.length = static_cast<size_t>(length);
+    json_number(line, "bytes_per_second", r.bytes_per_second);
+    json_number(line, "allocs_per_op", r.allocs_per_op);
+    json_number(line, "allocated_bytes_per_op", r.allocated_bytes_per_op);
+    results.push_back(r);
+  }
+  return true;
+}
+
+const Result* find_result(const std::vector<Result>& results, const Result& r) {
+  for (const Result& other : results) {
+    if (other.name == r.name && other.length == r.length) {
+      return &other;
+    }
+  }
+  return nullptr;
+}
+
+void print_result(const Result& r, const Result* base) {
+  char throughput[32] = "n/a";
+  if (r.bytes_per_second > 0) {
+    snprintf(throughput, sizeof(throughput), "%.1f", r.bytes_per_second / 1e6);
+  }
+  printf("%-14s %8zu %12.2f ns/op %10s MB/s %8.3f allocs/op %10.1f B/op", r.name.c_str(), r.length,
+         r.ns_per_op, throughput, r.allocs_per_op, r.allocated_bytes_per_op);
+  if (base != nullptr) {
+    printf("   base %12.2f ns/op %8.3f allocs/op  x%.2f", base->ns_per_op, base->allocs_per_op,
+           base->ns_per_op > 0 ? r.ns_per_op / base->ns_per_op : 0.0);
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+  const char* filter = nullptr;
+  const char* json_path = nullptr;
+  const char* baseline_path = nullptr;
+  double min_time = 0.05;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--filter") == 0 && has_value) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--json") == 0 && has_value) {
+      json_path = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && has_value) {
+      baseline_path = argv[++i];
+    } else if (strcmp(argv[i], "--min-time") == 0 && has_value) {
+      min_time = atof(argv[++i]) / 1000;
+    } else {
+      fprintf(stderr, "usage: %s [--filter text] [--min-time ms] [--json out.json] [--baseline old.json]\n", argv[0]);
+      return 1;
+    }
+  }
+  std::vector<Result> baseline;
+  if (baseline_path != nullptr && !read_json(baseline_path, baseline)) {
+    fprintf(stderr, "can't read %s\n", baseline_path);
+    return 1;
+  }
+  std::vector<Result> results;
+  for (const Benchmark& bench : kBenchmarks) {
+    if (filter != nullptr && strstr(bench.name, filter) == nullptr) {
+      continue;
+    }
+    for (size_t length : kLengths) {
+      results.push_back(measure(bench, length, min_time));
+      print_result(results.back(), find_result(baseline, results.back()));
+    }
+  }
+  if (json_path != nullptr) {
+    std::ofstream stream(json_path);
+    if (!stream) {
+      fprintf(stderr, "can't write %s\n", json_path);
+      return 1;
+    }
+    write_json(stream, results);
+  }
+  return 0;
+}
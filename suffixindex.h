@@ -0,0 +1,481 @@
+#ifndef suffixindex_h
+#define suffixindex_h
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "string.h"
+
+// Suffix array with LCP over a fixed text, for answering many substring
+// queries without rescanning the text. The index doesn't own the text,
+// which must outlive it. Texts are limited to 2^31 - 1 bytes.
+// A query finds the block of suffixes starting with the pattern by binary
+// search, skipping the prefix already known to match on both bounds.
+// find and rfind take the minimum or maximum position of that block using
+// precomputed minima and maxima of every kBlock suffixes.
+// The serialized form is the header followed by the arrays exactly as they
+// are kept in memory, so load can use a mapped file without copying. The
+// arrays are therefore in the byte order of the machine that saved them,
+// and load rejects an index saved with the other byte order.
+class SuffixIndex {
+ public:
+  SuffixIndex ();
+
+  explicit SuffixIndex (StringView);
+
+  SuffixIndex (const SuffixIndex&) = delete;
+
+  SuffixIndex (SuffixIndex&&) = default;
+
+  SuffixIndex& operator=(const SuffixIndex&) = delete;
+
+  SuffixIndex& operator=(SuffixIndex&&) = default;
+
+  // Returns false if the text is too long
+  bool build(StringView);
+
+  // data has to stay alive as long as the index if it is 4-byte aligned,
+  // otherwise it is copied. Returns false if data isn't an index of text:
+  // the header has to match the size and the hash of text, and every
+  // stored position has to be inside text. The order of the suffixes
+  // isn't verified.
+  bool load(StringView text, StringView data);
+
+  void save(std::ostream&) const;
+
+  size_t size() const;
+
+  // Starting position of the i-th smallest suffix
+  size_t suffix(size_t) const;
+
+  // Length of the common prefix of the (i - 1)-th and i-th suffixes, 0 for i = 0
+  size_t lcp(size_t) const;
+
+  // Same results as String::find and String::rfind
+  size_t find(StringView) const;
+
+  size_t rfind(StringView) const;
+
+  // The empty pattern has no occurrences here
+  size_t count(StringView) const;
+
+  // Ascending positions
+  std::vector<size_t> locate_all(StringView) const;
+ private:
+  static const size_t kBlock = 64;
+  static const char kMagic[8];
+  static const size_t kHeaderSize = 40;
+
+  StringView text;
+  size_t blocks = 0;
+  // sa[n], lcp[n], block_min[blocks], block_max[blocks] back to back,
+  // either in owned or in the data passed to load
+  const int32_t* arrays = nullptr;
+  std::vector<int32_t> owned;
+
+  template<typename Symbol>
+  static std::vector<int32_t> sais(const Symbol*, int32_t, int32_t);
+
+  const int32_t* sa() const;
+
+  const int32_t* block_min() const;
+
+  const int32_t* block_max() const;
+
+  static bool little_endian();
+
+  static void put_number(char*, uint64_t);
+
+  static uint64_t get_number(const char*);
+
+  void range(StringView, size_t&, size_t&) const;
+
+  size_t match(size_t, StringView, size_t) const;
+
+  template<typename Better>
+  int32_t best(size_t, size_t, const int32_t*, Better) const;
+};
+
+const char SuffixIndex::kMagic[8] = {'S', 'U', 'F', 'I', 'D', 'X', '0', '1'};
+
+SuffixIndex::SuffixIndex() {}
+
+SuffixIndex::SuffixIndex(StringView text) {
+  build(text);
+}
+
+// SA-IS: sorts the LMS substrings by induction, names them, sorts the
+// reduced string recursively if the names aren't unique, then induces
+// the full order from the sorted LMS suffixes. Symbols are in [0, upper].
+template<typename Symbol>
+std::vector<int32_t> SuffixIndex::sais(const Symbol* s, int32_t n, int32_t upper) {
+  if (n == 0) {
+    return {};
+  }
+  if (n == 1) {
+    return {0};
+  }
+  if (n == 2) {
+    return s[0] < s[1] ? std::vector<int32_t>{0, 1} : std::vector<int32_t>{1, 0};
+  }
+  std::vector<int32_t> sa(n);
+  // ls[i]: suffix i is smaller than suffix i + 1
+  std::vector<uint8_t> ls(n, 0);
+  for (int32_t i = n - 2; i >= 0; --i) {
+    ls[i] = s[i] == s[i + 1] ? ls[i + 1] : s[i] < s[i + 1];
+  }
+  // bucket of symbol c: L-suffixes from sum_l[c], S-suffixes from sum_s[c]
+  std::vector<int32_t> sum_l(upper + 1, 0);
+  std::vector<int32_t> sum_s(upper + 1, 0);
+  for (int32_t i = 0; i < n; ++i) {
+    if (!ls[i]) {
+      ++sum_s[s[i]];
+    } else {
+      ++sum_l[s[i] + 1];
+    }
+  }
+  for (int32_t c = 0; c <= upper; ++c) {
+    sum_s[c] += sum_l[c];
+    if (c < upper) {
+      sum_l[c + 1] += sum_s[c];
+    }
+  }
+  std::vector<int32_t> bucket(upper + 1);
+  auto induce = [&](const std::vector<int32_t>& lms) {
+    std::fill(sa.begin(), sa.end(), -1);
+    std::copy(sum_s.begin(), sum_s.end(), bucket.begin());
+    for (int32_t d : lms) {
+      sa[bucket[s[d]]++] = d;
+    }
+    std::copy(sum_l.begin(), sum_l.end(), bucket.begin());
+    sa[bucket[s[n - 1]]++] = n - 1;
+    for (int32_t i = 0; i < n; ++i) {
+      int32_t v = sa[i];
+      if (v >= 1 && !ls[v - 1]) {
+        sa[bucket[s[v - 1]]++] = v - 1;
+      }
+    }
+    std::copy(sum_l.begin(), sum_l.end(), bucket.begin());
+    for (int32_t i = n - 1; i >= 0; --i) {
+      int32_t v = sa[i];
+      if (v >= 1 && ls[v - 1]) {
+        sa[--bucket[s[v - 1] + 1]] = v - 1;
+      }
+    }
+  };
+  std::vector<int32_t> lms_index(n + 1, -1);
+  std::vector<int32_t> lms;
+  for (int32_t i = 1; i < n; ++i) {
+    if (!ls[i - 1] && ls[i]) {
+      lms_index[i] = static_cast<int32_t>(lms.size());
+      lms.push_back(i);
+    }
+  }
+  int32_t m = static_cast<int32_t>(lms.size());
+  induce(lms);
+  if (m == 0) {
+    return sa;
+  }
+  std::vector<int32_t> sorted;
+  sorted.reserve(m);
+  for (int32_t v : sa) {
+    if (lms_index[v] != -1) {
+      sorted.push_back(v);
+    }
+  }
+  // equal LMS substrings get equal names
+  std::vector<int32_t> reduced(m);
+  int32_t names = 0;
+  reduced[lms_index[sorted[0]]] = 0;
+  for (int32_t i = 1; i < m; ++i) {
+    int32_t l = sorted[i - 1];
+    int32_t r = sorted[i];
+    int32_t end_l = lms_index[l] + 1 < m ? lms[lms_index[l] + 1] : n;
+    int32_t end_r = lms_index[r] + 1 < m ? lms[lms_index[r] + 1] : n;
+    bool same = end_l - l == end_r - r;
+    if (same) {
+      while (l < end_l && s[l] == s[r]) {
+        ++l;
+        ++r;
+      }
+      same = l != n && s[l] == s[r];
+    }
+    if (!same) {
+      ++names;
+    }
+    reduced[lms_index[sorted[i]]] = names;
+  }
+  std::vector<int32_t> reduced_sa = sais(reduced.data(), m, names);
+  for (int32_t i = 0; i < m; ++i) {
+    sorted[i] = lms[reduced_sa[i]];
+  }
+  induce(sorted);
+  return sa;
+}
+
+// LCP by Kasai: the common prefix with the preceding suffix shrinks
+// by at most one from suffix i to suffix i + 1
+bool SuffixIndex::build(StringView source) {
+  if (source.size() > static_cast<size_t>(INT32_MAX)) {
+    return false;
+  }
+  text = source;
+  int32_t n = static_cast<int32_t>(text.size());
+  blocks = (text.size() + kBlock - 1) / kBlock;
+  std::vector<int32_t> suffixes = sais(reinterpret_cast<const unsigned char*>(text.data()), n, 255);
+  owned.assign(2 * text.size() + 2 * blocks, 0);
+  std::copy(suffixes.begin(), suffixes.end(), owned.begin());
+  int32_t* lcp_values = owned.data() + n;
+  std::vector<int32_t> rank(n);
+  for (int32_t i = 0; i < n; ++i) {
+    rank[suffixes[i]] = i;
+  }
+  suffixes = std::vector<int32_t>();
+  const int32_t* sa_values = owned.data();
+  int32_t h = 0;
+  for (int32_t i = 0; i < n; ++i) {
+    if (rank[i] == 0) {
+      h = 0;
+      continue;
+    }
+    int32_t j = sa_values[rank[i] - 1];
+    while (i + h < n && j + h < n && text[i + h] == text[j + h]) {
+      ++h;
+    }
+    lcp_values[rank[i]] = h;
+    if (h > 0) {
+      --h;
+    }
+  }
+  int32_t* minima = lcp_values + n;
+  int32_t* maxima = minima + blocks;
+  for (size_t b = 0; b < blocks; ++b) {
+    const int32_t* first = sa_values + b * kBlock;
+    const int32_t* last = sa_values + std::min((b + 1) * kBlock, text.size());
+    minima[b] = *std::min_element(first, last);
+    maxima[b] = *std::max_element(first, last);
+  }
+  arrays = owned.data();
+  return true;
+}
+
+bool SuffixIndex::little_endian() {
+  const uint32_t one = 1;
+  unsigned char first;
+  memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+void SuffixIndex::put_number(char* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out[i] = static_cast<char>(value >> (8 * i));
+  }
+}
+
+uint64_t SuffixIndex::get_number(const char* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+  }
+  return value;
+}
+
+// Header: magic, then text size, block count, hash of the text and the
+// byte order of the arrays (0 little-endian, 1 big-endian) as 8-byte
+// little-endian numbers
+void SuffixIndex::save(std::ostream& stream) const {
+  char header[kHeaderSize];
+  memcpy(header, kMagic, sizeof(kMagic));
+  put_number(header + 8, text.size());
+  put_number(header + 16, blocks);
+  put_number(header + 24, hashBytes(text.data(), text.size()));
+  put_number(header + 32, little_endian() ? 0 : 1);
+  stream.write(header, sizeof(header));
+  if (arrays != nullptr) {
+    stream.write(reinterpret_cast<const char*>(arrays), (2 * text.size() + 2 * blocks) * sizeof(int32_t));
+  }
+}
+
+bool SuffixIndex::load(StringView source, StringView data) {
+  if (data.size() < kHeaderSize || memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+  uint64_t n = get_number(data.data() + 8);
+  uint64_t block_count = get_number(data.data() + 16);
+  if (n != source.size() || block_count != (source.size() + kBlock - 1) / kBlock ||
+      data.size() != kHeaderSize + (2 * n + 2 * block_count) * sizeof(int32_t) ||
+      get_number(data.data() + 32) != (little_endian() ? 0 : 1) ||
+      get_number(data.data() + 24) != static_cast<uint64_t>(hashBytes(source.data(), source.size()))) {
+    return false;
+  }
+  const char* payload = data.data() + kHeaderSize;
+  const int32_t* values = reinterpret_cast<const int32_t*>(payload);
+  std::vector<int32_t> copy;
+  if (reinterpret_cast<uintptr_t>(payload) % alignof(int32_t) != 0) {
+    copy.resize(2 * n + 2 * block_count);
+    if (!copy.empty()) {
+      memcpy(copy.data(), payload, copy.size() * sizeof(int32_t));
+    }
+    values = copy.data();
+  }
+  // sa and the block minima and maxima are used as positions in the text
+  for (size_t i = 0; i < 2 * n + 2 * block_count; ++i) {
+    bool position = i < n || i >= 2 * n;
+    if (position && (values[i] < 0 || static_cast<uint64_t>(values[i]) >= n)) {
+      return false;
+    }
+  }
+  text = source;
+  blocks = block_count;
+  owned = std::move(copy);
+  owned.shrink_to_fit();
+  arrays = owned.empty() ? values : owned.data();
+  return true;
+}
+
+size_t SuffixIndex::size() const {
+  return text.size();
+}
+
+const int32_t* SuffixIndex::sa() const {
+  return arrays;
+}
+
+const int32_t* SuffixIndex::block_min() const {
+  return arrays + 2 * text.size();
+}
+
+const int32_t* SuffixIndex::block_max() const {
+  return block_min() + blocks;
+}
+
+size_t SuffixIndex::suffix(size_t i) const {
+  return sa()[i];
+}
+
+size_t SuffixIndex::lcp(size_t i) const {
+  return arrays[text.size() + i];
+}
+
+// Extends a match of the first k characters of pattern at suffix i,
+// returns the length of the common prefix
+size_t SuffixIndex::match(size_t i, StringView pattern, size_t k) const {
+  size_t start = sa()[i];
+  size_t limit = std::min(pattern.size(), text.size() - start);
+  while (k < limit && text[start + k] == pattern[k]) {
+    ++k;
+  }
+  return k;
+}
+
+// [first, last) receives the suffixes that start with pattern. Every
+// suffix between the bounds shares at least min(lcp_low, lcp_high)
+// characters with pattern, so those are never compared again.
+void SuffixIndex::range(StringView pattern, size_t& first, size_t& last) const {
+  size_t m = pattern.size();
+  size_t n = text.size();
+  size_t low = 0;
+  size_t high = n;
+  size_t lcp_low = 0;
+  size_t lcp_high = 0;
+  // first suffix that isn't smaller than pattern
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    size_t k = match(mid, pattern, std::min(lcp_low, lcp_high));
+    size_t start = sa()[mid];
+    if (k == m || (start + k < n && static_cast<unsigned char>(text[start + k]) > static_cast<unsigned char>(pattern[k]))) {
+      high = mid;
+      lcp_high = k;
+    } else {
+      low = mid + 1;
+      lcp_low = k;
+    }
+  }
+  first = low;
+  // first suffix after that which doesn't start with pattern
+  high = n;
+  lcp_low = m;
+  lcp_high = 0;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    size_t k = match(mid, pattern, std::min(lcp_low, lcp_high));
+    if (k == m) {
+      low = mid + 1;
+      lcp_low = k;
+    } else {
+      high = mid;
+      lcp_high = k;
+    }
+  }
+  last = low;
+}
+
+// Best of sa[first, last) by the comparison, whole blocks through values
+template<typename Better>
+int32_t SuffixIndex::best(size_t first, size_t last, const int32_t* values, Better better) const {
+  int32_t res = sa()[first];
+  size_t i = first;
+  for (; i < last && i % kBlock != 0; ++i) {
+    res = better(sa()[i], res) ? sa()[i] : res;
+  }
+  for (; i + kBlock <= last; i += kBlock) {
+    res = better(values[i / kBlock], res) ? values[i / kBlock] : res;
+  }
+  for (; i < last; ++i) {
+    res = better(sa()[i], res) ? sa()[i] : res;
+  }
+  return res;
+}
+
+size_t SuffixIndex::find(StringView pattern) const {
+  if (pattern.empty()) {
+    return 0;
+  }
+  size_t first = 0;
+  size_t last = 0;
+  range(pattern, first, last);
+  if (first == last) {
+    return text.size();
+  }
+  return best(first, last, block_min(), [](int32_t x, int32_t y) { return x < y; });
+}
+
+size_t SuffixIndex::rfind(StringView pattern) const {
+  if (pattern.empty()) {
+    return text.size();
+  }
+  size_t first = 0;
+  size_t last = 0;
+  range(pattern, first, last);
+  if (first == last) {
+    return text.size();
+  }
+  return best(first, last, block_max(), [](int32_t x, int32_t y) { return x > y; });
+}
+
+size_t SuffixIndex::count(StringView pattern) const {
+  if (pattern.empty()) {
+    return 0;
+  }
+  size_t first = 0;
+  size_t last = 0;
+  range(pattern, first, last);
+  return last - first;
+}
+
+std::vector<size_t> SuffixIndex::locate_all(StringView pattern) const {
+  std::vector<size_t> positions;
+  if (pattern.empty()) {
+    return positions;
+  }
+  size_t first = 0;
+  size_t last = 0;
+  range(pattern, first, last);
+  positions.assign(sa() + first, sa() + last);
+  std::sort(positions.begin(), positions.end());
+  return positions;
+}
+
+#endif /* suffixindex_h */